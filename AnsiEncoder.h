@@ -0,0 +1,266 @@
+#ifndef ANSIENCODER_H
+#define ANSIENCODER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "ScreenBackend.h"
+
+// Turns frames into the bytes an ANSI terminal needs to show them, diffed
+// against the frame before: cells that did not change are skipped with the
+// shortest cursor movement, and colours are set only where a run of cells
+// changes them. The whole frame is built in one string that keeps its
+// capacity, for a single write().
+//
+// The encoder tracks the terminal's cursor and colours between frames, so
+// nothing else may write to the terminal unless reset() is called first.
+class AnsiEncoder {
+public:
+    AnsiEncoder() {
+        output.reserve(1 << 16);
+    }
+
+    // Forgets the screen, for when something else drew on it: the next
+    // frame is written out whole
+    void reset() {
+        previous.clear();
+        cursorKnown = false;
+        attributes = -1;
+    }
+
+    // Bytes that bring the screen from the last frame to this one; empty if
+    // nothing changed. Valid until the next call.
+    const std::string& encode(const ConsoleFrame& frame) {
+        output.clear();
+
+        const size_t cellCount = static_cast<size_t>(frame.width) * static_cast<size_t>(frame.height);
+        if (frame.width != width || frame.height != height || previous.size() != cellCount) {
+            // Resized, or first frame: the terminal may have reflowed what was
+            // there, so start from a clear screen
+            width = frame.width;
+            height = frame.height;
+            previous.clear();
+            output += "\x1b[0m\x1b[2J";
+            cursorKnown = false;
+            attributes = -1;
+        }
+        const bool whole = previous.empty();
+
+        for (int y = 0; y < height; y++) {
+            const CHAR_INFO* row = frame.cells.data() + static_cast<size_t>(y) * width;
+            const CHAR_INFO* before = whole ? nullptr : previous.data() + static_cast<size_t>(y) * width;
+            for (int x = 0; x < width; x++) {
+                if (!whole && sameCell(row[x], before[x])) continue;
+                moveTo(row, x, y);
+                put(row[x]);
+            }
+        }
+
+        previous.assign(frame.cells.begin(), frame.cells.end());
+        return output;
+    }
+
+    size_t lastFrameBytes() const {
+        return output.size();
+    }
+
+private:
+    std::string output;
+    std::vector<CHAR_INFO> previous; // as the terminal shows it
+    short width = 0;
+    short height = 0;
+
+    // Where the terminal's cursor is and which colours it writes with
+    bool cursorKnown = false;
+    int cursorX = 0;
+    int cursorY = 0;
+    int attributes = -1; // -1: unknown
+
+    static bool sameCell(const CHAR_INFO& a, const CHAR_INFO& b) {
+        return a.Char.UnicodeChar == b.Char.UnicodeChar && a.Attributes == b.Attributes;
+    }
+
+    static uint32_t codePoint(const CHAR_INFO& cell) {
+        return static_cast<std::make_unsigned_t<WCHAR>>(cell.Char.UnicodeChar);
+    }
+
+    static size_t utf8Length(const uint32_t code) {
+        return code < 0x80 ? 1 : code < 0x800 ? 2 : code < 0x10000 ? 3 : 4;
+    }
+
+    static int digits(int value) {
+        int count = 1;
+        while (value >= 10) {
+            value /= 10;
+            count++;
+        }
+        return count;
+    }
+
+    void appendNumber(int value) {
+        char text[12];
+        int length = 0;
+        do {
+            text[length++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (length > 0) output += text[--length];
+    }
+
+    // CSI n <final>, with n left out when it is 1
+    void appendRelative(const int count, const char final) {
+        output += "\x1b[";
+        if (count != 1) appendNumber(count);
+        output += final;
+    }
+
+    static int relativeLength(const int count) {
+        return 3 + (count != 1 ? digits(count) : 0);
+    }
+
+    // Cheapest way to the cell: an absolute move, a relative one, a carriage
+    // return and line feeds, or rewriting the few cells in between when they
+    // are already in the current colours
+    void moveTo(const CHAR_INFO* row, const int x, const int y) {
+        if (cursorKnown && cursorX == x && cursorY == y) return;
+
+        // CSI row ; col H, with col left out in the first column
+        const int absolute = 3 + digits(y + 1) + (x > 0 ? 1 + digits(x + 1) : 0);
+        if (!cursorKnown) {
+            appendAbsolute(x, y);
+            return;
+        }
+
+        enum class Way { Absolute, Forward, Back, Down, Up, Return, Rewrite } way = Way::Absolute;
+        int best = absolute;
+        const auto consider = [&best, &way](const int cost, const Way candidate) {
+            if (cost < best) {
+                best = cost;
+                way = candidate;
+            }
+        };
+
+        if (y == cursorY) {
+            if (x > cursorX) {
+                consider(relativeLength(x - cursorX), Way::Forward);
+                int rewrite = 0;
+                for (int i = cursorX; i < x && rewrite < best; i++) {
+                    rewrite = (row[i].Attributes & 0xFF) == attributes ? rewrite + static_cast<int>(utf8Length(codePoint(row[i]))) : best;
+                }
+                consider(rewrite, Way::Rewrite);
+            } else {
+                consider(relativeLength(cursorX - x), Way::Back);
+            }
+        } else if (x == cursorX) {
+            consider(relativeLength(std::abs(y - cursorY)), y > cursorY ? Way::Down : Way::Up);
+        }
+        if (x == 0 && y >= cursorY) {
+            const int lines = y - cursorY;
+            consider(1 + std::min(lines, relativeLength(lines)), Way::Return);
+        }
+
+        switch (way) {
+            case Way::Absolute:
+                appendAbsolute(x, y);
+                return;
+            case Way::Forward:
+                appendRelative(x - cursorX, 'C');
+                break;
+            case Way::Back:
+                appendRelative(cursorX - x, 'D');
+                break;
+            case Way::Down:
+                appendRelative(y - cursorY, 'B');
+                break;
+            case Way::Up:
+                appendRelative(cursorY - y, 'A');
+                break;
+            case Way::Return:
+                output += '\r';
+                if (y - cursorY <= relativeLength(y - cursorY)) {
+                    output.append(static_cast<size_t>(y - cursorY), '\n');
+                } else {
+                    appendRelative(y - cursorY, 'B');
+                }
+                break;
+            case Way::Rewrite:
+                for (int i = cursorX; i < x; i++) appendUtf8(codePoint(row[i]));
+                break;
+        }
+        cursorX = x;
+        cursorY = y;
+    }
+
+    void appendAbsolute(const int x, const int y) {
+        output += "\x1b[";
+        appendNumber(y + 1);
+        if (x > 0) {
+            output += ';';
+            appendNumber(x + 1);
+        }
+        output += 'H';
+        cursorKnown = true;
+        cursorX = x;
+        cursorY = y;
+    }
+
+    // Console attribute colour bits are blue, green, red; ANSI's are red, green, blue
+    static int ansiColor(const int bits) {
+        return ((bits & 4) ? 1 : 0) | (bits & 2) | ((bits & 1) ? 4 : 0);
+    }
+
+    static int foreground(const int attributes) {
+        return ansiColor(attributes & 0x7) + ((attributes & 0x08) ? 90 : 30);
+    }
+
+    static int background(const int attributes) {
+        return ansiColor((attributes >> 4) & 0x7) + ((attributes & 0x80) ? 100 : 40);
+    }
+
+    void put(const CHAR_INFO& cell) {
+        const int wanted = cell.Attributes & 0xFF;
+        if (wanted != attributes) {
+            // Only the half that changed
+            const bool foregroundChanged = attributes < 0 || foreground(wanted) != foreground(attributes);
+            const bool backgroundChanged = attributes < 0 || background(wanted) != background(attributes);
+            output += "\x1b[";
+            if (foregroundChanged) appendNumber(foreground(wanted));
+            if (foregroundChanged && backgroundChanged) output += ';';
+            if (backgroundChanged) appendNumber(background(wanted));
+            output += 'm';
+            attributes = wanted;
+        }
+
+        appendUtf8(codePoint(cell));
+
+        // Writing the last column leaves the cursor waiting to wrap, and
+        // terminals disagree on where that is
+        cursorX++;
+        if (cursorX >= width) cursorKnown = false;
+    }
+
+    void appendUtf8(const uint32_t code) {
+        if (code < 0x80) {
+            output += static_cast<char>(code < 0x20 ? ' ' : code);
+        } else if (code < 0x800) {
+            output += static_cast<char>(0xC0 | (code >> 6));
+            output += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            output += static_cast<char>(0xE0 | (code >> 12));
+            output += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            output += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            output += static_cast<char>(0xF0 | (code >> 18));
+            output += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            output += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            output += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+};
+
+#endif // ANSIENCODER_H
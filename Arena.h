@@ -0,0 +1,133 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+struct ArenaStats {
+    size_t upstreamAllocations = 0; // chunks requested from the system (malloc calls)
+    size_t upstreamBytes = 0;
+    size_t allocations = 0;         // allocations served from chunks
+    size_t bytesAllocated = 0;
+    size_t resets = 0;
+};
+
+// Bump allocator for short-lived search data. Nothing is freed individually;
+// reset() rewinds to the first chunk and keeps every chunk for the next search,
+// so once warmed up a search makes no further system allocations.
+class MonotonicArena : public std::pmr::memory_resource {
+public:
+    explicit MonotonicArena(const size_t chunkSize = 1 << 20) : chunkSize(chunkSize) {}
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena() override {
+        release();
+    }
+
+    // Per-thread arena, shared by everything a search thread allocates
+    static MonotonicArena& forThread() {
+        thread_local MonotonicArena arena;
+        return arena;
+    }
+
+    void reset() {
+        current = 0;
+        offset = 0;
+        stats.resets++;
+    }
+
+    // Returns all chunks to the system
+    void release() {
+        for (const Chunk& chunk : chunks) {
+            ::operator delete(chunk.data, std::align_val_t{alignof(std::max_align_t)});
+        }
+        chunks.clear();
+        current = 0;
+        offset = 0;
+    }
+
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Chunk& chunk : chunks) total += chunk.size;
+        return total;
+    }
+
+    const ArenaStats& getStats() const {
+        return stats;
+    }
+
+    void resetStats() {
+        stats = {};
+    }
+
+private:
+    struct Chunk {
+        std::byte* data;
+        size_t size;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t chunkSize;
+    size_t current = 0; // chunk being bumped
+    size_t offset = 0;  // first free byte in chunks[current]
+    ArenaStats stats;
+
+    void* do_allocate(const size_t bytes, const size_t alignment) override {
+        while (current < chunks.size()) {
+            // Align the address itself: chunks are only aligned to max_align_t
+            const auto base = reinterpret_cast<uintptr_t>(chunks[current].data);
+            const size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+            if (aligned + bytes <= chunks[current].size) {
+                offset = aligned + bytes;
+                stats.allocations++;
+                stats.bytesAllocated += bytes;
+                return chunks[current].data + aligned;
+            }
+            current++;
+            offset = 0;
+        }
+
+        const size_t size = std::max(chunkSize, bytes + alignment);
+        auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t{alignof(std::max_align_t)}));
+        chunks.push_back({data, size});
+        stats.upstreamAllocations++;
+        stats.upstreamBytes += size;
+
+        current = chunks.size() - 1;
+        offset = 0;
+        return do_allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Resets the arena when a search finishes, however it finishes
+class ArenaScope {
+public:
+    explicit ArenaScope(MonotonicArena& arena) : arena(arena) {}
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    ~ArenaScope() {
+        arena.reset();
+    }
+
+private:
+    MonotonicArena& arena;
+};
+
+template <typename T>
+using ArenaVector = std::pmr::vector<T>;
+
+#endif // ARENA_H
@@ -0,0 +1,232 @@
+#ifndef BEAMSOLVER_H
+#define BEAMSOLVER_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_set>
+#include <vector>
+
+#include "Arena.h"
+#include "Canonical.h"
+#include "Endgame.h"
+#include "Evaluator.h"
+#include "Position.h"
+#include "Rules.h"
+#include "Solver.h"
+
+struct BeamOptions {
+    size_t width = 256;                 // positions kept per depth, to start with
+    size_t memoryCap = 64 << 20;        // bytes of search memory, beyond it the search gives up
+    std::chrono::milliseconds timeBudget{1000};
+    size_t maxDepth = 1024;
+    Canonicalization canonical = Canonicalization::Columns;
+    EvalWeights weights;
+};
+
+// Breadth-first search that keeps only the best options.width positions of
+// each depth, as scored by the Evaluator, so memory and time stay bounded
+// where the depth-first Solver's visited set can grow without limit. It
+// returns a solution, or Unknown once the time budget or the memory cap is
+// spent. A deal is only Unsolvable when the beam never had to drop a
+// position: children are every legal move, so the search was exhaustive.
+//
+// A beam can die out: every child of its positions was kept at an earlier
+// depth. With time left the search then starts over at twice the width, as
+// long as the last search stayed within half the memory cap.
+//
+// Children are every legal move, scored in EvalBatch blocks. Every kept
+// position is remembered, so no later depth keeps it again. A kept position
+// stores only its parent and its move, which is enough to rebuild the
+// solution. Positions, links and the visited set come from the calling
+// thread's arena, which each search starts afresh.
+template <typename Rules>
+class BeamSolver {
+public:
+    explicit BeamSolver(const BeamOptions& options = {})
+        : options(options), evaluator(options.weights) {}
+
+    SolverOutcome solve(const Position& start) const {
+        const Clock::time_point deadline = Clock::now() + options.timeBudget;
+
+        SolverOutcome outcome;
+        for (size_t width = std::max<size_t>(1, options.width);; width *= 2) {
+            const size_t memoryBefore = outcome.stats.memoryBytes;
+            outcome.stats.memoryBytes = 0;
+            const bool diedOut = search(start, width, deadline, outcome);
+            outcome.stats.memoryBytes = std::max(outcome.stats.memoryBytes, memoryBefore);
+
+            if (!diedOut || outcome.stats.memoryBytes > options.memoryCap / 2 || Clock::now() > deadline) {
+                return outcome;
+            }
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t SCORE_BLOCK = 1024; // positions scored per EvalBatch
+    static_assert(SCORE_BLOCK % EvalBatch::LANES == 0);
+
+    struct Candidate {
+        uint64_t key;
+        float score;
+        uint32_t parent; // index in the beam
+        EngineMove move;
+    };
+
+    struct Link {
+        uint32_t parent;
+        EngineMove move;
+    };
+
+    BeamOptions options;
+    Evaluator evaluator;
+
+    // One beam search of the given width, adding to outcome. True if the beam
+    // died out after dropping positions, when a wider beam may still win.
+    bool search(const Position& start, const size_t width, const Clock::time_point deadline, SolverOutcome& outcome) const {
+        MonotonicArena& arena = MonotonicArena::forThread();
+        ArenaScope scope(arena);
+        const size_t allocatedBefore = arena.getStats().bytesAllocated;
+
+        SolverStats& stats = outcome.stats;
+        outcome.result = SolveResult::Unknown;
+
+        EvalBatch batch(SCORE_BLOCK);
+        std::array<float, SCORE_BLOCK> scores;
+
+        ArenaVector<Position> beam(&arena);
+        ArenaVector<Position> next(&arena);
+        beam.reserve(width);
+        next.reserve(width);
+        std::vector<Candidate> candidates; // grows to the widest depth, then is reused
+
+        // layers[d][i] leads from a position of depth d to position i of depth d + 1
+        ArenaVector<ArenaVector<Link>> layers(&arena);
+        layers.reserve(options.maxDepth);
+
+        std::pmr::unordered_set<uint64_t> visited(&arena);
+        visited.reserve(width * 16);
+
+        const auto memoryUsed = [&] {
+            return arena.getStats().bytesAllocated - allocatedBefore + candidates.capacity() * sizeof(Candidate) +
+                   (EVAL_FEATURES + 1) * scores.size() * sizeof(float);
+        };
+
+        // Scores the candidates added since the last block was scored
+        size_t scored = 0;
+        const auto scoreBlock = [&] {
+            evaluator.evaluate(batch, scores.data());
+            for (size_t i = 0; i < batch.size(); i++) candidates[scored + i].score = scores[i];
+            scored += batch.size();
+            batch.clear();
+        };
+
+        EndgameOrder endgame;
+        beam.push_back(start);
+        visited.insert(canonicalHash(start, options.canonical));
+        if (solveEndgame(start, endgame)) {
+            outcome.solution.assign(endgame.moves.begin(), endgame.moves.begin() + endgame.count);
+            outcome.result = SolveResult::Solved;
+            stats.memoryBytes = memoryUsed();
+            return false;
+        }
+
+        bool pruned = false;
+        std::array<EngineMove, Rules::maxMoves> moves;
+        while (!beam.empty()) {
+            stats.memoryBytes = std::max(stats.memoryBytes, memoryUsed());
+            if (layers.size() == options.maxDepth || stats.memoryBytes > options.memoryCap || Clock::now() > deadline) {
+                return false;
+            }
+
+            // Every child not kept at an earlier depth
+            candidates.clear();
+            scored = 0;
+            for (size_t parent = 0; parent < beam.size(); parent++) {
+                // A wide depth can outgrow the cap before the next depth's check
+                if ((parent & 255) == 255) {
+                    stats.memoryBytes = std::max(stats.memoryBytes, memoryUsed());
+                    if (stats.memoryBytes > options.memoryCap || Clock::now() > deadline) return false;
+                }
+
+                Position& pos = beam[parent];
+                const int count = generateMoves<Rules>(pos, moves.data());
+                for (int i = 0; i < count; i++) {
+                    const MoveRecord record = applyMove<Rules>(pos, moves[i]);
+                    stats.nodes++;
+                    const uint64_t key = canonicalHash(pos, options.canonical);
+                    if (visited.contains(key)) {
+                        stats.transpositions++;
+                    } else {
+                        if (batch.size() == SCORE_BLOCK) scoreBlock();
+                        candidates.push_back({key, 0.0f, static_cast<uint32_t>(parent), moves[i]});
+                        batch.add(pos);
+                    }
+                    undoMove<Rules>(pos, record);
+                }
+            }
+            scoreBlock();
+            stats.memoryBytes = std::max(stats.memoryBytes, memoryUsed());
+            if (stats.memoryBytes > options.memoryCap) return false;
+
+            // Several parents can reach the same child; it only needs keeping once
+            std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+                return a.key < b.key;
+            });
+            candidates.erase(std::unique(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+                return a.key == b.key;
+            }), candidates.end());
+
+            if (candidates.size() > width) {
+                std::nth_element(candidates.begin(), candidates.begin() + static_cast<ptrdiff_t>(width), candidates.end(),
+                                 [](const Candidate& a, const Candidate& b) {
+                                     return a.score != b.score ? a.score > b.score : a.key < b.key;
+                                 });
+                candidates.resize(width);
+                pruned = true;
+            }
+
+            ArenaVector<Link>& links = layers.emplace_back();
+            links.reserve(candidates.size());
+            next.clear();
+            for (const Candidate& candidate : candidates) {
+                visited.insert(candidate.key);
+                links.push_back({candidate.parent, candidate.move});
+                Position& child = next.emplace_back(beam[candidate.parent]);
+                applyMove<Rules>(child, candidate.move);
+
+                // Everything revealed and the stock used up: the rest is a
+                // straight run to the foundations
+                if (solveEndgame(child, endgame)) {
+                    outcome.solution = pathTo(layers, next.size() - 1);
+                    outcome.solution.insert(outcome.solution.end(), endgame.moves.begin(), endgame.moves.begin() + endgame.count);
+                    outcome.result = SolveResult::Solved;
+                    stats.maxDepth = std::max(stats.maxDepth, layers.size());
+                    stats.memoryBytes = std::max(stats.memoryBytes, memoryUsed());
+                    return false;
+                }
+            }
+            std::swap(beam, next);
+            if (!beam.empty()) stats.maxDepth = std::max(stats.maxDepth, layers.size());
+        }
+
+        if (!pruned) outcome.result = SolveResult::Unsolvable;
+        return pruned;
+    }
+
+    // Moves from the start to position index of the deepest layer
+    static std::vector<EngineMove> pathTo(const ArenaVector<ArenaVector<Link>>& layers, size_t index) {
+        std::vector<EngineMove> path(layers.size());
+        for (size_t depth = layers.size(); depth-- > 0;) {
+            path[depth] = layers[depth][index].move;
+            index = layers[depth][index].parent;
+        }
+        return path;
+    }
+};
+
+#endif // BEAMSOLVER_H
@@ -0,0 +1,84 @@
+#ifndef CANONICAL_H
+#define CANONICAL_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include "Position.h"
+
+// How much symmetry a transposition lookup should merge
+enum class Canonicalization {
+    None,            // exact position, column and foundation order matter
+    Columns,         // tableau columns and foundation piles are interchangeable
+    ColumnsAndSuits  // as Columns, and suits of the same colour may be swapped
+};
+
+namespace detail {
+    // Suit relabelings that keep colours: identity, swap reds, swap blacks, both
+    constexpr std::array<std::array<uint8_t, 4>, 4> colourPreservingSwaps = {{
+        {0, 1, 2, 3},
+        {1, 0, 2, 3},
+        {0, 1, 3, 2},
+        {1, 0, 3, 2},
+    }};
+
+    inline CardId relabel(const CardId card, const std::array<uint8_t, 4>& suits) {
+        return static_cast<CardId>(suits[card / 13] * 13 + card % 13);
+    }
+
+    inline uint64_t canonicalHashWith(const Position& pos, const std::array<uint8_t, 4>& suits) {
+        // Columns are hashed on their own and then sorted, so the result does
+        // not depend on which index a column happens to sit at
+        std::array<uint64_t, TABLEAU_COLUMNS> columns{};
+        for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+            uint64_t h = 0xcbf29ce484222325ULL ^ pos.faceDown[col];
+            for (int i = 0; i < pos.columnSize[col]; i++) {
+                h = (h ^ (relabel(pos.tableau[col][i], suits) + 1)) * 0x100000001b3ULL;
+            }
+            columns[col] = pos.columnSize[col] ? finalizeHash(h) : 0;
+        }
+        std::sort(columns.begin(), columns.end());
+
+        uint64_t h = 0x84222325cbf29ce4ULL;
+        const auto mix = [&h](const uint64_t value) {
+            h = (h ^ value) * 0x100000001b3ULL;
+        };
+        for (const uint64_t column : columns) {
+            mix(column);
+            mix(column >> 32);
+        }
+
+        // Foundations by suit level rather than by pile
+        std::array<int, 4> levels{};
+        for (const CardId top : pos.foundation) {
+            if (top != NO_CARD) levels[suits[top / 13]] = rankValue(top);
+        }
+        for (const int level : levels) mix(0x200 | level);
+
+        mix(0x300 | pos.cursor | (pos.recycles << 16));
+        for (int i = 0; i < pos.stockSize; i++) mix(relabel(pos.stock[i], suits));
+
+        return finalizeHash(h);
+    }
+}
+
+inline uint64_t canonicalHash(const Position& pos, const Canonicalization level) {
+    switch (level) {
+        case Canonicalization::None:
+            return positionHash(pos);
+        case Canonicalization::Columns:
+            return detail::canonicalHashWith(pos, detail::colourPreservingSwaps[0]);
+        case Canonicalization::ColumnsAndSuits: {
+            // Smallest hash over the colour-preserving relabelings is the representative
+            uint64_t best = UINT64_MAX;
+            for (const auto& suits : detail::colourPreservingSwaps) {
+                best = std::min(best, detail::canonicalHashWith(pos, suits));
+            }
+            return best;
+        }
+    }
+    return positionHash(pos);
+}
+
+#endif // CANONICAL_H
@@ -5,42 +5,40 @@
 #ifndef CARDSTASH_H
 #define CARDSTASH_H
 
-#include <vector>
-
 #include "Card.h"
 #include "ConsoleColors.h"
 
+// Draws the top of a pile owned elsewhere (stock or waste side of a StockPile)
 class CardStash : public Renderable {
 public:
-    std::vector<Card> cards;
-
     CardStash() : Renderable(8, 8) {}
 
-    bool renderBorder() const {
-        return size() > 1;
-    }
-
-    void push(const Card& card) {
-        cards.push_back(card);
-    }
-
-    void pop() {
-        if (!cards.empty()) {
-            return cards.pop_back();
+    // Called every frame; the top card is compared by value because the
+    // pile may hold a different card at the same address after a move
+    void setContents(const Card* top, const size_t count, const bool faceUp) {
+        const size_t newCount = top ? count : 0;
+        const bool same = newCount == cardCount && faceUp == topFaceUp &&
+                          (!top || (top->suit == shownSuit && top->rank == shownRank));
+        topCard = top;
+        cardCount = newCount;
+        topFaceUp = faceUp;
+        if (top) {
+            shownSuit = top->suit;
+            shownRank = top->rank;
         }
+        if (!same) markDirty();
     }
 
-    const Card& peek() const {
-        if (cards.empty()) throw std::out_of_range("CardStash is empty");
-        return cards.back();
+    bool renderBorder() const {
+        return size() > 1;
     }
 
     bool empty() const {
-        return cards.empty();
+        return cardCount == 0;
     }
 
     size_t size() const {
-        return cards.size();
+        return cardCount;
     }
 
     void render(ScreenBuffer& screen) const {
@@ -56,12 +54,19 @@ public:
             drawText(screen, 0, 6, L"+", FG_WHITE | BG_GREEN);
         }
 
-        Card topCard = cards.back();
-        topCard.setPos(posX + renderBorder(), posY + renderBorder());
-        topCard.render(screen);
+        Card card = *topCard;
+        card.isFaceUp = topFaceUp;
+        card.setPos(posX + renderBorder(), posY + renderBorder());
+        card.render(screen);
     }
 
 private:
+    const Card* topCard = nullptr;
+    size_t cardCount = 0;
+    bool topFaceUp = false;
+    Suit shownSuit{};
+    Rank shownRank{};
+
     void drawEmptyPlaceholder(ScreenBuffer& screen) const {
         const std::array<std::wstring, 7> placeholder = {
             L"+-----+",
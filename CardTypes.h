@@ -0,0 +1,32 @@
+#ifndef CARDTYPES_H
+#define CARDTYPES_H
+
+enum class Suit {
+    Hearts = 0, 
+    Diamonds,
+    Clubs,
+    Spades,
+    None
+};
+
+enum class Rank {
+    Ace = 1,    // A = 1
+    Two = 2,    // 2 = 2
+    Three = 3,  // 3 = 3
+    Four = 4,   // 4 = 4
+    Five = 5,   // 5 = 5
+    Six = 6,    // 6 = 6
+    Seven = 7,  // 7 = 7
+    Eight = 8,  // 8 = 8
+    Nine = 9,   // 9 = 9
+    Ten = 10,   // 10 = 10
+    Jack = 11,  // J = 11
+    Queen = 12, // Q = 12
+    King = 13   // K = 13
+};
+
+inline bool isRedSuit(const Suit suit) {
+    return suit == Suit::Hearts || suit == Suit::Diamonds;
+}
+
+#endif // CARDTYPES_H
@@ -0,0 +1,35 @@
+#ifndef CONSOLEAPI_H
+#define CONSOLEAPI_H
+
+// The Windows console types the screen code is written against. Elsewhere
+// they are stood in for with the same layout and attribute bits, so the UI
+// can draw into a ScreenBuffer whose frames go to a terminal or to memory.
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cstdint>
+
+using WORD = uint16_t;
+using SHORT = int16_t;
+using WCHAR = wchar_t;
+
+struct CHAR_INFO {
+    union {
+        WCHAR UnicodeChar;
+        char AsciiChar;
+    } Char;
+    WORD Attributes;
+};
+
+constexpr WORD FOREGROUND_BLUE      = 0x0001;
+constexpr WORD FOREGROUND_GREEN     = 0x0002;
+constexpr WORD FOREGROUND_RED       = 0x0004;
+constexpr WORD FOREGROUND_INTENSITY = 0x0008;
+constexpr WORD BACKGROUND_BLUE      = 0x0010;
+constexpr WORD BACKGROUND_GREEN     = 0x0020;
+constexpr WORD BACKGROUND_RED       = 0x0040;
+constexpr WORD BACKGROUND_INTENSITY = 0x0080;
+#endif
+
+#endif // CONSOLEAPI_H
@@ -0,0 +1,79 @@
+#ifndef CONSOLEBACKEND_H
+#define CONSOLEBACKEND_H
+
+#include <Windows.h>
+
+#include "Logger.h"
+#include "ScreenBackend.h"
+
+// A console screen buffer of its own; activate() switches the console
+// window to it
+class ConsoleBackend : public ScreenBackend {
+public:
+    ConsoleBackend() {
+        hConsoleBuffer = CreateConsoleScreenBuffer(
+            GENERIC_READ | GENERIC_WRITE,
+            0,
+            nullptr,
+            CONSOLE_TEXTMODE_BUFFER,
+            nullptr
+        );
+
+        if (hConsoleBuffer == INVALID_HANDLE_VALUE) {
+            Logger::error("Failed to create screen buffer");
+            exit(1);
+        }
+    }
+
+    ConsoleBackend(const ConsoleBackend&) = delete;
+    ConsoleBackend& operator=(const ConsoleBackend&) = delete;
+
+    void initialSize(short& width, short& height) override {
+        CONSOLE_SCREEN_BUFFER_INFO csbi;
+        if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi)) {
+            Logger::error("Failed to get screen info");
+            exit(1);
+        }
+
+        width = static_cast<short>(csbi.srWindow.Right - csbi.srWindow.Left + 1);
+        height = static_cast<short>(csbi.srWindow.Bottom - csbi.srWindow.Top + 1);
+    }
+
+    // The console has no resize notification for screen buffers, so this asks every time
+    bool resized(short& width, short& height) override {
+        CONSOLE_SCREEN_BUFFER_INFO csbi;
+        if (!GetConsoleScreenBufferInfo(hConsoleBuffer, &csbi)) {
+            Logger::error("GetConsoleScreenBufferInfo failed");
+            return false;
+        }
+
+        width = static_cast<short>(csbi.srWindow.Right - csbi.srWindow.Left + 1);
+        height = static_cast<short>(csbi.srWindow.Bottom - csbi.srWindow.Top + 1);
+        return true;
+    }
+
+    void activate() override {
+        if (!SetConsoleActiveScreenBuffer(hConsoleBuffer)) {
+            Logger::error("Failed to activate screen buffer");
+        }
+    }
+
+    void present(const ConsoleFrame& frame) override {
+        SMALL_RECT rect = {0, 0, static_cast<SHORT>(frame.width - 1), static_cast<SHORT>(frame.height - 1)};
+        const COORD bufferSize = {frame.width, frame.height};
+        constexpr COORD bufferCoord = {0, 0};
+
+        WriteConsoleOutputW(
+            hConsoleBuffer,
+            frame.cells.data(),
+            bufferSize,
+            bufferCoord,
+            &rect
+        );
+    }
+
+private:
+    HANDLE hConsoleBuffer;
+};
+
+#endif // CONSOLEBACKEND_H
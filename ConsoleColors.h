@@ -5,7 +5,7 @@
 #ifndef CONSOLECOLORS_H
 #define CONSOLECOLORS_H
 
-#include <Windows.h>
+#include "ConsoleApi.h"
 
 // Foreground colors
 constexpr WORD FG_BLACK   = 0;
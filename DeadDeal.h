@@ -0,0 +1,113 @@
+#ifndef DEADDEAL_H
+#define DEADDEAL_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#include "Position.h"
+
+// Why findDeadDeal gave up on a deal
+enum class DeadDeal : uint8_t {
+    None,    // not shown to be lost, the solver has to decide
+    NoMoves, // nothing can be played from the tableau or the stock, pass after pass
+    Deadlock // tableau cards that can never leave their columns
+};
+
+inline const char* deadDealName(const DeadDeal dead) {
+    switch (dead) {
+        case DeadDeal::None:     return "none";
+        case DeadDeal::NoMoves:  return "noMoves";
+        case DeadDeal::Deadlock: return "deadlock";
+    }
+    return "?";
+}
+
+namespace detail {
+    // Only drawing and recycling: no tableau top can be played, and neither
+    // can any of the waste tops a pass through the stock shows. Nothing leaves
+    // the stock, so every later pass shows the same cards. In a fresh deal
+    // each column's only face-up card is its top.
+    template <typename Rules>
+    bool onlyStockMoves(const Position& deal) {
+        CardMask shown = deal.tops;
+        for (int cursor = 0; cursor < deal.stockSize;) {
+            cursor = std::min(cursor + Rules::drawCount, static_cast<int>(deal.stockSize));
+            shown |= cardBit(deal.stock[cursor - 1]);
+        }
+
+        bool emptyColumn = false;
+        for (int col = 0; col < TABLEAU_COLUMNS; col++) emptyColumn |= deal.columnSize[col] == 0;
+        for (CardMask cards = emptyColumn ? shown : 0; cards != 0; cards &= cards - 1) {
+            if (Rules::canStartColumn(static_cast<CardId>(std::countr_zero(cards)))) return false;
+        }
+
+        return (shown & (deal.foundationNext() | deal.acceptedByTops())) == 0;
+    }
+
+    // A card leaves its column for the foundation, once the card below it in
+    // its suit is there, or onto one of the two cards it stacks on. If each of
+    // those cards lies under a card of some set, in its own column, then no
+    // card of the set can be the first to leave, and none ever does. The card
+    // below in the suit is as good as buried when it is in the set itself: it
+    // never reaches the foundation. The set starts as every card that could be
+    // in it, and cards with a way out are dropped until none is left to drop.
+    //
+    // Only for a fresh deal. There no face-up card sits on another, so a card
+    // under one of the set can only come out after that card has left.
+    template <typename Rules>
+    CardMask stuckCards(const Position& deal) {
+        if (Rules::anyCardStartsColumn) return 0; // any card may go to an empty column
+
+        // Aces always go to the foundations, Kings may find an empty column
+        struct Candidate {
+            CardId card;
+            CardMask below;   // the card below in its suit
+            CardMask targets; // the cards it stacks on
+            CardMask under;   // cards under it in its column
+        };
+        Candidate candidates[DECK_SIZE];
+        int count = 0;
+        for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+            CardMask under = 0;
+            for (int i = 0; i < deal.columnSize[col]; i++) {
+                const CardId card = deal.tableau[col][i];
+                if (rankValue(card) != 1 && !Rules::canStartColumn(card)) {
+                    candidates[count++] = {card, cardBit(static_cast<CardId>(card - 1)), stackTargets(card), under};
+                }
+                under |= cardBit(card);
+            }
+        }
+
+        CardMask stuck = 0;
+        for (int i = 0; i < count; i++) stuck |= cardBit(candidates[i].card);
+        for (bool dropped = true; dropped && stuck != 0;) {
+            CardMask buried = 0;
+            for (int i = 0; i < count; i++) {
+                if (stuck & cardBit(candidates[i].card)) buried |= candidates[i].under;
+            }
+
+            dropped = false;
+            for (int i = 0; i < count; i++) {
+                const Candidate& c = candidates[i];
+                if ((stuck & cardBit(c.card)) && ((c.below & ~(buried | stuck)) || (c.targets & ~buried))) {
+                    stuck &= ~cardBit(c.card);
+                    dropped = true;
+                }
+            }
+        }
+        return stuck;
+    }
+}
+
+// Cheap checks that prove a fresh deal can't be won, for dealing and batch
+// solving to skip it before any search. A deal flagged here is lost under
+// the given rules; one that passes may still be lost.
+template <typename Rules>
+DeadDeal findDeadDeal(const Position& deal) {
+    if (detail::stuckCards<Rules>(deal)) return DeadDeal::Deadlock;
+    if (detail::onlyStockMoves<Rules>(deal)) return DeadDeal::NoMoves;
+    return DeadDeal::None;
+}
+
+#endif // DEADDEAL_H
@@ -0,0 +1,136 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <array>
+#include <cstdint>
+
+#include "Position.h"
+
+// Winning order found by solveEndgame, all TableauToFoundation moves
+struct EndgameOrder {
+    std::array<EngineMove, DECK_SIZE> moves{};
+    int count = 0;
+};
+
+// Lets solveEndgame read a Position through the same interface as
+// std::vector<TableauPile> / std::vector<FoundationPile>
+class PositionTableauView {
+public:
+    class Column {
+    public:
+        Column(const Position& pos, const int index) : pos(pos), index(index) {}
+        size_t size() const { return pos.columnSize[index]; }
+        int countFaceDown() const { return pos.faceDown[index]; }
+        CardId get(const size_t i) const { return pos.tableau[index][i]; }
+    private:
+        const Position& pos;
+        int index;
+    };
+
+    explicit PositionTableauView(const Position& pos) : pos(pos) {}
+    size_t size() const { return TABLEAU_COLUMNS; }
+    Column operator[](const size_t i) const { return {pos, static_cast<int>(i)}; }
+
+private:
+    const Position& pos;
+};
+
+class PositionFoundationView {
+public:
+    class Pile {
+    public:
+        explicit Pile(const CardId top) : top(top) {}
+        bool empty() const { return top == NO_CARD; }
+        CardId peek() const { return top; }
+    private:
+        CardId top;
+    };
+
+    explicit PositionFoundationView(const Position& pos) : pos(pos) {}
+    size_t size() const { return FOUNDATION_PILES; }
+    Pile operator[](const size_t i) const { return Pile(pos.foundation[i]); }
+
+private:
+    const Position& pos;
+};
+
+// Decides an endgame where the stock and waste are used up and every tableau
+// card is face up, and fills in the winning order. The caller checks that the
+// stock and waste are empty.
+//
+// Plays the lowest-needed cards off column tops until nothing fits. Under
+// Klondike rules face-up cards always form descending runs, so the lowest card
+// left is never covered and this always succeeds; it returns false when some
+// card is still face down or a hand-built column has a card under a higher one.
+//
+// Works on anything shaped like the piles: tableau[i].size(), countFaceDown(),
+// get(j) and foundations[i].empty(), peek(), with toCardId() for the cards.
+template <typename Tableau, typename Foundations>
+bool solveEndgame(const Tableau& tableau, const Foundations& foundations, EndgameOrder& order) {
+    order.count = 0;
+
+    std::array<int, TABLEAU_COLUMNS> heights{};
+    int remaining = 0;
+    for (size_t col = 0; col < tableau.size(); col++) {
+        if (tableau[col].countFaceDown() > 0) return false;
+        heights[col] = static_cast<int>(tableau[col].size());
+        remaining += heights[col];
+    }
+
+    // Foundation level and pile per suit; aces take the first free pile
+    std::array<int, 4> level{};
+    std::array<int, 4> pileOfSuit{-1, -1, -1, -1};
+    std::array<bool, FOUNDATION_PILES> pileUsed{};
+    for (size_t pile = 0; pile < foundations.size(); pile++) {
+        if (foundations[pile].empty()) continue;
+        const CardId top = toCardId(foundations[pile].peek());
+        level[top / 13] = rankValue(top);
+        pileOfSuit[top / 13] = static_cast<int>(pile);
+        pileUsed[pile] = true;
+    }
+
+    bool progress = true;
+    while (remaining > 0 && progress) {
+        progress = false;
+        for (size_t col = 0; col < tableau.size(); col++) {
+            while (heights[col] > 0) {
+                const CardId card = toCardId(tableau[col].get(heights[col] - 1));
+                const int suit = card / 13;
+                if (rankValue(card) != level[suit] + 1) break;
+
+                if (pileOfSuit[suit] < 0) {
+                    for (int pile = 0; pile < FOUNDATION_PILES; pile++) {
+                        if (!pileUsed[pile]) {
+                            pileUsed[pile] = true;
+                            pileOfSuit[suit] = pile;
+                            break;
+                        }
+                    }
+                }
+
+                order.moves[order.count++] = {EngineMove::Type::TableauToFoundation, static_cast<uint8_t>(col),
+                                              static_cast<uint8_t>(pileOfSuit[suit]), 1};
+                level[suit]++;
+                heights[col]--;
+                remaining--;
+                progress = true;
+            }
+        }
+    }
+
+    return remaining == 0;
+}
+
+inline bool isEndgame(const Position& pos) {
+    if (pos.stockSize != 0) return false;
+    for (const uint8_t faceDown : pos.faceDown) {
+        if (faceDown) return false;
+    }
+    return true;
+}
+
+inline bool solveEndgame(const Position& pos, EndgameOrder& order) {
+    return isEndgame(pos) && solveEndgame(PositionTableauView(pos), PositionFoundationView(pos), order);
+}
+
+#endif // ENDGAME_H
@@ -0,0 +1,290 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EVALUATOR_SSE2 1
+#endif
+
+#include "Position.h"
+
+// What the evaluator looks at in a position, each a count
+enum class EvalFeature : uint8_t {
+    FaceDown,     // cards still to turn over in the tableau
+    OnFoundation, // cards on the foundations
+    EmptyColumns,
+    BuriedAces,   // face down in the tableau
+    BlockedKings, // in the tableau above other cards, so one more column must be cleared for each
+    StockCards,   // in the stock and waste
+    Count
+};
+
+constexpr size_t EVAL_FEATURES = static_cast<size_t>(EvalFeature::Count);
+
+constexpr std::array<std::string_view, EVAL_FEATURES> EVAL_FEATURE_NAMES = {
+    "faceDown", "onFoundation", "emptyColumns", "buriedAces", "blockedKings", "stockCards"};
+
+// A weight per feature; a position scores the weighted sum of its features
+struct EvalWeights {
+    std::array<float, EVAL_FEATURES> weights = {-5.0f, 10.0f, 4.0f, -3.0f, -2.0f, -0.5f};
+
+    float& operator[](const EvalFeature feature) {
+        return weights[static_cast<size_t>(feature)];
+    }
+
+    float operator[](const EvalFeature feature) const {
+        return weights[static_cast<size_t>(feature)];
+    }
+
+    // Reads "name value" lines, # starts a comment. Features not named keep
+    // their weight. False with a message on an unknown name or bad number.
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream in(path);
+        if (!in) {
+            error = path + ": cannot open";
+            return false;
+        }
+
+        std::string line;
+        for (size_t number = 1; std::getline(in, line); number++) {
+            if (const size_t comment = line.find('#'); comment != std::string::npos) line.erase(comment);
+
+            std::istringstream words(line);
+            std::string name;
+            if (!(words >> name)) continue;
+
+            size_t feature = 0;
+            while (feature < EVAL_FEATURES && EVAL_FEATURE_NAMES[feature] != name) feature++;
+            float value = 0;
+            if (feature == EVAL_FEATURES || !(words >> value)) {
+                error = path + ":" + std::to_string(number) + ": " +
+                        (feature == EVAL_FEATURES ? "unknown feature " + name : "bad weight for " + name);
+                return false;
+            }
+            weights[feature] = value;
+        }
+        return true;
+    }
+};
+
+// Kings in the tableau with other cards under them
+inline CardMask blockedKings(const Position& pos) {
+    constexpr CardMask KINGS = ACES << 12;
+
+    CardMask bottoms = 0;
+    for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+        if (pos.columnSize[col] != 0) bottoms |= cardBit(pos.tableau[col][0]);
+    }
+    return (pos.faceUp | pos.faceDownCards) & KINGS & ~bottoms;
+}
+
+// Features of a position, read off its card masks
+inline std::array<float, EVAL_FEATURES> evalFeatures(const Position& pos) {
+    std::array<float, EVAL_FEATURES> features{};
+    features[static_cast<size_t>(EvalFeature::FaceDown)] = static_cast<float>(std::popcount(pos.faceDownCards));
+    features[static_cast<size_t>(EvalFeature::OnFoundation)] = static_cast<float>(std::popcount(pos.onFoundation));
+    features[static_cast<size_t>(EvalFeature::EmptyColumns)] = static_cast<float>(TABLEAU_COLUMNS - std::popcount(pos.tops));
+    features[static_cast<size_t>(EvalFeature::BuriedAces)] = static_cast<float>(std::popcount(pos.faceDownCards & ACES));
+    features[static_cast<size_t>(EvalFeature::BlockedKings)] = static_cast<float>(std::popcount(blockedKings(pos)));
+    features[static_cast<size_t>(EvalFeature::StockCards)] = static_cast<float>(pos.stockSize);
+    return features;
+}
+
+// Positions to score together, stored as the masks their features count,
+// one array per mask: add() only copies masks, and the scoring loop takes
+// the popcounts of several positions per instruction. Arrays hold a whole
+// number of SIMD lanes; lanes past size() hold whatever was there and their
+// scores are ignored.
+class EvalBatch {
+public:
+    static constexpr size_t LANES = 8;
+
+    enum Mask { FaceDown, OnFoundation, Tops, BlockedKings, MASKS };
+
+    explicit EvalBatch(const size_t capacity) : capacity(capacity) {
+        for (std::vector<CardMask>& column : masks) column.assign(padded(capacity), 0);
+        stock.assign(padded(capacity), 0.0f);
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    // False once the batch holds capacity positions
+    bool add(const Position& pos) {
+        if (count == capacity) return false;
+        masks[FaceDown][count] = pos.faceDownCards;
+        masks[OnFoundation][count] = pos.onFoundation;
+        masks[Tops][count] = pos.tops;
+        masks[BlockedKings][count] = blockedKings(pos);
+        stock[count] = static_cast<float>(pos.stockSize);
+        count++;
+        return true;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    const CardMask* mask(const Mask which) const {
+        return masks[which].data();
+    }
+
+    const float* stockCards() const {
+        return stock.data();
+    }
+
+    static size_t padded(const size_t positions) {
+        return (positions + LANES - 1) / LANES * LANES;
+    }
+
+private:
+    size_t capacity;
+    size_t count = 0;
+    std::array<std::vector<CardMask>, MASKS> masks;
+    std::vector<float> stock;
+};
+
+// Scores positions with a weighted sum of their features. Higher is better.
+// A batch is scored with AVX2 or SSE2 when the compiler targets them, and a
+// plain loop otherwise. Neither needs the popcnt instruction: set bits are
+// counted per byte (a nibble table with AVX2, shifts and adds with SSE2)
+// and the bytes of each mask summed with psadbw.
+class Evaluator {
+public:
+    explicit Evaluator(const EvalWeights& weights = {}) : weights(weights) {}
+
+    float evaluate(const Position& pos) const {
+        const std::array<float, EVAL_FEATURES> features = evalFeatures(pos);
+        float score = 0;
+        for (size_t f = 0; f < EVAL_FEATURES; f++) score += weights.weights[f] * features[f];
+        return score;
+    }
+
+    // Writes batch.size() scores; scores must have room for
+    // EvalBatch::padded(batch.size())
+    void evaluate(const EvalBatch& batch, float* scores) const {
+        const size_t end = EvalBatch::padded(batch.size());
+        const CardMask* faceDown = batch.mask(EvalBatch::FaceDown);
+        const CardMask* onFoundation = batch.mask(EvalBatch::OnFoundation);
+        const CardMask* tops = batch.mask(EvalBatch::Tops);
+        const CardMask* blocked = batch.mask(EvalBatch::BlockedKings);
+        const float* stock = batch.stockCards();
+        const auto weight = [this](const EvalFeature feature) { return weights[feature]; };
+
+#if defined(__AVX2__)
+        const __m256i aces = _mm256_set1_epi64x(static_cast<long long>(ACES));
+        const __m256 columns = _mm256_set1_ps(static_cast<float>(TABLEAU_COLUMNS));
+        const __m256 wFaceDown = _mm256_set1_ps(weight(EvalFeature::FaceDown));
+        const __m256 wFoundation = _mm256_set1_ps(weight(EvalFeature::OnFoundation));
+        const __m256 wEmpty = _mm256_set1_ps(weight(EvalFeature::EmptyColumns));
+        const __m256 wAces = _mm256_set1_ps(weight(EvalFeature::BuriedAces));
+        const __m256 wKings = _mm256_set1_ps(weight(EvalFeature::BlockedKings));
+        const __m256 wStock = _mm256_set1_ps(weight(EvalFeature::StockCards));
+        const auto load = [](const CardMask* masks) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks)); };
+        for (size_t i = 0; i < end; i += 8) {
+            const __m256i downLow = load(faceDown + i), downHigh = load(faceDown + i + 4);
+            __m256 sum = _mm256_mul_ps(wFaceDown, counts(downLow, downHigh));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(wFoundation, counts(load(onFoundation + i), load(onFoundation + i + 4))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(wEmpty, _mm256_sub_ps(columns, counts(load(tops + i), load(tops + i + 4)))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(wAces, counts(_mm256_and_si256(downLow, aces), _mm256_and_si256(downHigh, aces))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(wKings, counts(load(blocked + i), load(blocked + i + 4))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(wStock, _mm256_loadu_ps(stock + i)));
+            _mm256_storeu_ps(scores + i, sum);
+        }
+#elif defined(EVALUATOR_SSE2)
+        const __m128i aces = _mm_set1_epi64x(static_cast<long long>(ACES));
+        const __m128 columns = _mm_set1_ps(static_cast<float>(TABLEAU_COLUMNS));
+        const __m128 wFaceDown = _mm_set1_ps(weight(EvalFeature::FaceDown));
+        const __m128 wFoundation = _mm_set1_ps(weight(EvalFeature::OnFoundation));
+        const __m128 wEmpty = _mm_set1_ps(weight(EvalFeature::EmptyColumns));
+        const __m128 wAces = _mm_set1_ps(weight(EvalFeature::BuriedAces));
+        const __m128 wKings = _mm_set1_ps(weight(EvalFeature::BlockedKings));
+        const __m128 wStock = _mm_set1_ps(weight(EvalFeature::StockCards));
+        const auto load = [](const CardMask* masks) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks)); };
+        for (size_t i = 0; i < end; i += 4) {
+            const __m128i downLow = load(faceDown + i), downHigh = load(faceDown + i + 2);
+            __m128 sum = _mm_mul_ps(wFaceDown, counts(downLow, downHigh));
+            sum = _mm_add_ps(sum, _mm_mul_ps(wFoundation, counts(load(onFoundation + i), load(onFoundation + i + 2))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(wEmpty, _mm_sub_ps(columns, counts(load(tops + i), load(tops + i + 2)))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(wAces, counts(_mm_and_si128(downLow, aces), _mm_and_si128(downHigh, aces))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(wKings, counts(load(blocked + i), load(blocked + i + 2))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(wStock, _mm_loadu_ps(stock + i)));
+            _mm_storeu_ps(scores + i, sum);
+        }
+#else
+        for (size_t i = 0; i < end; i++) {
+            scores[i] = weight(EvalFeature::FaceDown) * static_cast<float>(std::popcount(faceDown[i])) +
+                        weight(EvalFeature::OnFoundation) * static_cast<float>(std::popcount(onFoundation[i])) +
+                        weight(EvalFeature::EmptyColumns) * static_cast<float>(TABLEAU_COLUMNS - std::popcount(tops[i])) +
+                        weight(EvalFeature::BuriedAces) * static_cast<float>(std::popcount(faceDown[i] & ACES)) +
+                        weight(EvalFeature::BlockedKings) * static_cast<float>(std::popcount(blocked[i])) +
+                        weight(EvalFeature::StockCards) * stock[i];
+        }
+#endif
+    }
+
+    // Which instructions evaluate(batch) was built with
+    static constexpr const char* instructionSet() {
+#if defined(__AVX2__)
+        return "AVX2";
+#elif defined(EVALUATOR_SSE2)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+    const EvalWeights& getWeights() const {
+        return weights;
+    }
+
+private:
+    EvalWeights weights;
+
+#if defined(__AVX2__)
+    // Set bits of the masks in low and high, as eight floats in mask order
+    static __m256 counts(const __m256i low, const __m256i high) {
+        const __m256i nibbles = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+        const auto perMask = [&](const __m256i v) {
+            const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(nibbles, _mm256_and_si256(v, lowNibble)),
+                                                  _mm256_shuffle_epi8(nibbles, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibble)));
+            return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+        };
+        // Low 32 bits of each 64-bit count, then the halves back in order
+        const __m256 packed = _mm256_shuffle_ps(_mm256_castsi256_ps(perMask(low)), _mm256_castsi256_ps(perMask(high)),
+                                                _MM_SHUFFLE(2, 0, 2, 0));
+        return _mm256_cvtepi32_ps(_mm256_permute4x64_epi64(_mm256_castps_si256(packed), _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+#elif defined(EVALUATOR_SSE2)
+    // Set bits of the masks in low and high, as four floats in mask order
+    static __m128 counts(const __m128i low, const __m128i high) {
+        const auto perMask = [](__m128i v) {
+            v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi64(v, 1), _mm_set1_epi8(0x55)));
+            v = _mm_add_epi8(_mm_and_si128(v, _mm_set1_epi8(0x33)), _mm_and_si128(_mm_srli_epi64(v, 2), _mm_set1_epi8(0x33)));
+            v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi64(v, 4)), _mm_set1_epi8(0x0F));
+            return _mm_sad_epu8(v, _mm_setzero_si128());
+        };
+        const __m128 packed = _mm_shuffle_ps(_mm_castsi128_ps(perMask(low)), _mm_castsi128_ps(perMask(high)),
+                                             _MM_SHUFFLE(2, 0, 2, 0));
+        return _mm_cvtepi32_ps(_mm_castps_si128(packed));
+    }
+#endif
+};
+
+#endif // EVALUATOR_H
@@ -16,10 +16,13 @@ public:
 
     void push(const Card& card) {
         cards.push_back(card);
+        markDirty();
     }
 
     void pop() {
-        if (!cards.empty()) cards.pop_back();
+        if (cards.empty()) return;
+        cards.pop_back();
+        markDirty();
     }
 
     const Card& peek() const {
@@ -37,6 +40,7 @@ public:
 
     void reset() {
         cards.clear();
+        markDirty();
     }
 
     void render(ScreenBuffer& screen) {
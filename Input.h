@@ -4,7 +4,15 @@
 
 #ifndef INPUT_H
 #define INPUT_H
+
+#include <chrono>
+#include <cstdint>
+
+#ifdef _WIN32
 #include <conio.h>
+#endif
+
+using InputClock = std::chrono::steady_clock;
 
 enum class InputKey {
     None,
@@ -18,11 +26,12 @@ enum class InputKey {
 struct KeyEvent {
     InputKey key;
     char ch;
+    InputClock::time_point time{}; // when the key was read, for measuring input latency
 };
 
-inline KeyEvent getInput() {
-    if (!_kbhit()) return {InputKey::None, 0};
-
+#ifdef _WIN32
+// Blocks until a key is pressed
+inline KeyEvent readConsoleKey() {
     const int first = _getch();
 
     if (first == 0 || first == 224) {
@@ -39,5 +48,70 @@ inline KeyEvent getInput() {
 
     return {InputKey::Character, static_cast<char>(first)};
 }
+#endif
+
+// Turns the bytes a POSIX terminal sends into KeyEvents, one byte at a time,
+// so a sequence split across reads still decodes. Arrows arrive as ESC [ C /
+// ESC [ D, or ESC O C / ESC O D in application cursor mode; other sequences
+// are swallowed whole.
+class KeyDecoder {
+public:
+    // True once the byte completes a key
+    bool feed(const unsigned char byte, KeyEvent& event) {
+        switch (state) {
+            case State::Escape:
+                if (byte == '[' || byte == 'O') {
+                    state = State::Sequence;
+                    return false;
+                }
+                state = State::Ground; // Alt+key: drop the ESC, keep the key
+                break;
+
+            case State::Sequence:
+                if (byte < 0x40 || byte > 0x7E) return false; // parameters, e.g. ESC [ 1 ; 5 C
+                state = State::Ground;
+                if (byte == 'C' || byte == 'D') {
+                    event = {byte == 'C' ? InputKey::RightArrow : InputKey::LeftArrow, 0};
+                    return true;
+                }
+                return false;
+
+            case State::Ground:
+                break;
+        }
+
+        if (byte == 0x1B) {
+            state = State::Escape;
+            return false;
+        }
+        if (byte == '\r' || byte == '\n') {
+            event = {InputKey::Enter, 0};
+            return true;
+        }
+        if (byte == 0x7F || byte == '\b') {
+            event = {InputKey::Backspace, 0};
+            return true;
+        }
+        if (byte < 0x20) return false;
+
+        event = {InputKey::Character, static_cast<char>(byte)};
+        return true;
+    }
+
+    // Inside an escape sequence: a lone ESC is only told apart by the
+    // silence after it
+    bool pending() const {
+        return state != State::Ground;
+    }
+
+    void reset() {
+        state = State::Ground;
+    }
+
+private:
+    enum class State : uint8_t { Ground, Escape, Sequence };
+
+    State state = State::Ground;
+};
 
 #endif //INPUT_H
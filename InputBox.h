@@ -25,10 +25,13 @@ public:
     void reset() {
         buffer.clear();
         cursorPos = 0;
+        markDirty();
     }
 
     void setActive(const bool isActive) {
+        if (isActive == active) return;
         active = isActive;
+        markDirty();
     }
 
     void handleInput(const KeyEvent& event) {
@@ -113,20 +116,24 @@ private:
 
     void moveCursorLeft() {
         if (cursorPos > 0) cursorPos--;
+        markDirty();
     }
 
     void moveCursorRight() {
         if (cursorPos < static_cast<int>(buffer.size())) cursorPos++;
+        markDirty();
     }
 
     void insertChar(wchar_t c) {
         buffer.insert(buffer.begin() + cursorPos, c);
         cursorPos++;
+        markDirty();
     }
 
     void removeChar() {
         if (cursorPos > 0 && !buffer.empty()) {
             buffer.erase(buffer.begin() + (--cursorPos));
+            markDirty();
         }
     }
 };
@@ -0,0 +1,196 @@
+#ifndef INPUTTHREAD_H
+#define INPUTTHREAD_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "Input.h"
+
+// Bounded ring shared by exactly one producer and one consumer thread,
+// without locks. Each side keeps a stale copy of the other's index and only
+// reloads it when the ring looks full or empty, so the indices' cache lines
+// are not bounced on every call.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer side: false if the ring is full
+    bool push(const T& value) {
+        const size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headCache == Capacity) {
+            headCache = headIndex.load(std::memory_order_acquire);
+            if (tail - headCache == Capacity) return false;
+        }
+        slots[tail & (Capacity - 1)] = value;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: appends everything pushed so far to out, returns how many
+    size_t drain(std::vector<T>& out) {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        const size_t tail = tailIndex.load(std::memory_order_acquire);
+        for (size_t i = head; i != tail; i++) {
+            out.push_back(slots[i & (Capacity - 1)]);
+        }
+        headIndex.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+    // Consumer side
+    bool empty() const {
+        return headIndex.load(std::memory_order_relaxed) == tailIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> headIndex{0};
+    alignas(64) std::atomic<size_t> tailIndex{0};
+    size_t headCache = 0; // producer's view of headIndex
+    std::array<T, Capacity> slots{};
+};
+
+// Reads keys on its own thread, blocking on the console or terminal, and
+// stamps each with the time it arrived. The game loop picks up everything
+// that arrived since its last frame with drain, so a key waits for at most
+// one frame and a burst of keys is handled together. With nothing queued,
+// drain sleeps until a key arrives or the timeout passes; the keys still go
+// through the lock-free ring, the mutex only guards the wake-up.
+//
+// On POSIX the thread reads fd (stdin by default, in whatever mode the
+// terminal is in) and decodes escape sequences with KeyDecoder.
+class InputThread {
+public:
+#ifdef _WIN32
+    InputThread() {
+        reader = std::thread([this] { run(); });
+    }
+#else
+    explicit InputThread(const int fd = STDIN_FILENO) : fd(fd) {
+        if (pipe(wakeFds) != 0) wakeFds[0] = wakeFds[1] = -1;
+        reader = std::thread([this] { run(); });
+    }
+#endif
+
+    ~InputThread() {
+        stopping.store(true, std::memory_order_relaxed);
+#ifndef _WIN32
+        if (wakeFds[1] >= 0) {
+            const char wake = 0;
+            [[maybe_unused]] const ssize_t written = write(wakeFds[1], &wake, 1);
+        }
+#endif
+        reader.join();
+#ifndef _WIN32
+        for (const int wakeFd : wakeFds) {
+            if (wakeFd >= 0) close(wakeFd);
+        }
+#endif
+    }
+
+    InputThread(const InputThread&) = delete;
+    InputThread& operator=(const InputThread&) = delete;
+
+    // Appends the keys that arrived since the last call, oldest first,
+    // waiting up to timeout for one if none has
+    size_t drain(std::vector<KeyEvent>& out, const std::chrono::milliseconds timeout = {}) {
+        if (queue.empty() && timeout.count() > 0) {
+            std::unique_lock lock(wakeMutex);
+            keyArrived.wait_for(lock, timeout, [this] { return !queue.empty(); });
+        }
+        return queue.drain(out);
+    }
+
+    // Keys lost because the game loop fell QUEUE_SIZE keys behind
+    uint32_t dropped() const {
+        return lost.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t QUEUE_SIZE = 256;
+
+    SpscQueue<KeyEvent, QUEUE_SIZE> queue;
+    std::atomic<uint32_t> lost{0};
+    std::atomic<bool> stopping{false};
+    std::mutex wakeMutex; // held by push to notify, so a drain about to wait cannot miss the key
+    std::condition_variable keyArrived;
+#ifndef _WIN32
+    int fd;
+    int wakeFds[2] = {-1, -1}; // written by the destructor to end a blocked poll
+#endif
+    std::thread reader;
+
+    void push(KeyEvent event, const InputClock::time_point time) {
+        if (event.key == InputKey::None) return;
+        event.time = time;
+        if (!queue.push(event)) {
+            lost.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::lock_guard lock(wakeMutex);
+        keyArrived.notify_one();
+    }
+
+#ifdef _WIN32
+    void run() {
+        const HANDLE console = GetStdHandle(STD_INPUT_HANDLE);
+        while (!stopping.load(std::memory_order_relaxed)) {
+            // Wakes up now and then to notice the destructor
+            if (WaitForSingleObject(console, 50) != WAIT_OBJECT_0) continue;
+            const InputClock::time_point time = InputClock::now();
+            while (_kbhit()) {
+                push(readConsoleKey(), time);
+            }
+        }
+    }
+#else
+    void run() {
+        // How long a lone ESC may wait for the rest of a sequence
+        constexpr int ESCAPE_TIMEOUT_MS = 25;
+
+        KeyDecoder decoder;
+        KeyEvent event{};
+        unsigned char bytes[64];
+        pollfd fds[2] = {{fd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+
+        while (!stopping.load(std::memory_order_relaxed)) {
+            const int ready = poll(fds, wakeFds[0] >= 0 ? 2 : 1, decoder.pending() ? ESCAPE_TIMEOUT_MS : -1);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            if (ready == 0) {
+                decoder.reset();
+                continue;
+            }
+            if (fds[1].revents) return;
+
+            const ssize_t count = read(fd, bytes, sizeof(bytes));
+            if (count < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+            if (count <= 0) return; // end of input
+
+            const InputClock::time_point time = InputClock::now();
+            for (ssize_t i = 0; i < count; i++) {
+                if (decoder.feed(bytes[i], event)) push(event, time);
+            }
+        }
+    }
+#endif
+};
+
+#endif // INPUTTHREAD_H
@@ -0,0 +1,56 @@
+#ifndef LABEL_H
+#define LABEL_H
+
+#include <string>
+
+#include "Renderable.h"
+
+// One line of text in a Scene, dirty only when its text or colour changes
+class Label : public Renderable {
+public:
+    Label() : Renderable(0, 1) {}
+
+    explicit Label(const std::wstring& text, const WORD color = FG_WHITE | 0) : Renderable(0, 1) {
+        setText(text, color);
+    }
+
+    void setText(const std::wstring& newText, const WORD newColor) {
+        if (newText != text) {
+            text = newText;
+            setSize(static_cast<int>(text.size()), 1);
+            markDirty();
+        }
+        setColor(newColor);
+    }
+
+    void setColor(const WORD newColor) {
+        if (newColor == color) return;
+        color = newColor;
+        markDirty();
+    }
+
+    void setVisible(const bool isVisible) {
+        if (isVisible == visible) return;
+        visible = isVisible;
+        markDirty();
+    }
+
+    const std::wstring& getText() const {
+        return text;
+    }
+
+    Rect bounds() const {
+        return visible ? Renderable::bounds() : Rect{};
+    }
+
+    void render(ScreenBuffer& screen) const {
+        if (visible && posX >= 0) drawText(screen, 0, 0, text, color);
+    }
+
+private:
+    std::wstring text;
+    WORD color = FG_WHITE | 0;
+    bool visible = true;
+};
+
+#endif // LABEL_H
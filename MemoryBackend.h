@@ -0,0 +1,107 @@
+#ifndef MEMORYBACKEND_H
+#define MEMORYBACKEND_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ScreenBackend.h"
+
+// A screen kept in memory, for running the UI with no console. The
+// backends it makes share it the way screen buffers share a console
+// window: each keeps its last frame, and activate() decides which one is
+// on show. Frames land on render threads; the calls here may come from
+// any thread.
+class MemoryDisplay {
+public:
+    MemoryDisplay(const short width, const short height) : width(width), height(height) {}
+
+    MemoryDisplay(const MemoryDisplay&) = delete;
+    MemoryDisplay& operator=(const MemoryDisplay&) = delete;
+
+    // The display must outlive the backend. Make them all before the first
+    // frame is rendered: each new one moves the screens the others draw to.
+    std::unique_ptr<ScreenBackend> makeBackend();
+
+    // Cells of the screen on show, as last presented
+    std::vector<CHAR_INFO> shown() const {
+        std::lock_guard lock(mutex);
+        return screens.empty() ? std::vector<CHAR_INFO>{} : screens[active];
+    }
+
+    // Frames presented so far, on any of the screens
+    uint64_t frames() const {
+        std::lock_guard lock(mutex);
+        return frameCount;
+    }
+
+    // When the last frame finished landing
+    InputClock::time_point lastLanded() const {
+        std::lock_guard lock(mutex);
+        return landedAt;
+    }
+
+    // False if fewer than count frames landed within the timeout
+    bool waitForFrames(const uint64_t count, const std::chrono::milliseconds timeout) const {
+        std::unique_lock lock(mutex);
+        return landed.wait_for(lock, timeout, [&] { return frameCount >= count; });
+    }
+
+private:
+    friend class MemoryBackend;
+
+    const short width;
+    const short height;
+
+    mutable std::mutex mutex;
+    mutable std::condition_variable landed;
+    std::vector<std::vector<CHAR_INFO>> screens; // last frame per backend
+    size_t active = 0;
+    uint64_t frameCount = 0;
+    InputClock::time_point landedAt{};
+};
+
+class MemoryBackend : public ScreenBackend {
+public:
+    MemoryBackend(MemoryDisplay& display, const size_t index) : display(display), index(index) {}
+
+    void initialSize(short& width, short& height) override {
+        width = display.width;
+        height = display.height;
+    }
+
+    // A memory screen is never resized
+    bool resized(short&, short&) override {
+        return false;
+    }
+
+    void activate() override {
+        std::lock_guard lock(display.mutex);
+        display.active = index;
+    }
+
+    void present(const ConsoleFrame& frame) override {
+        {
+            std::lock_guard lock(display.mutex);
+            display.screens[index].assign(frame.cells.begin(), frame.cells.end());
+            display.frameCount++;
+            display.landedAt = InputClock::now();
+        }
+        display.landed.notify_all();
+    }
+
+private:
+    MemoryDisplay& display;
+    size_t index;
+};
+
+inline std::unique_ptr<ScreenBackend> MemoryDisplay::makeBackend() {
+    std::lock_guard lock(mutex);
+    screens.emplace_back();
+    return std::make_unique<MemoryBackend>(*this, screens.size() - 1);
+}
+
+#endif // MEMORYBACKEND_H
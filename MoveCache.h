@@ -0,0 +1,372 @@
+#ifndef MOVECACHE_H
+#define MOVECACHE_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "Position.h"
+
+// The legal moves of one position, kept up to date as moves are applied and
+// undone instead of generated again each time. A move is a cell of a table
+// indexed by the pile it comes from and the pile it goes to; after a move
+// only the rows of its two piles, and the cells that target them, are worked
+// out again. Reading every move back walks the filled cells, so it costs the
+// number of moves rather than a scan of the table.
+//
+// Which rule set applies is a template parameter of the calls, as with the
+// engine functions; one cache must stay with one rule set.
+class MoveCache {
+public:
+    template <typename Rules>
+    void reset(const Position& pos) {
+        findEmptyColumns(pos);
+        for (int source = 0; source < SOURCES; source++) refreshSource<Rules>(pos, source);
+        refreshStock<Rules>(pos);
+    }
+
+    // Brings the cache up to date after move was applied to pos, or undone
+    template <typename Rules>
+    void update(const Position& pos, const EngineMove& move) {
+        uint16_t sources = 0;
+        uint8_t targets = 0;
+        switch (move.type) {
+            case EngineMove::Type::Draw:
+            case EngineMove::Type::Recycle:
+                sources = sourceBit(WASTE);
+                break;
+            case EngineMove::Type::WasteToFoundation:
+                sources = sourceBit(WASTE) | sourceBit(pileSource(move.to));
+                targets = targetBit(FOUNDATIONS);
+                break;
+            case EngineMove::Type::WasteToTableau:
+                sources = sourceBit(WASTE) | sourceBit(columnSource(move.to));
+                targets = targetBit(columnTarget(move.to));
+                break;
+            case EngineMove::Type::TableauToFoundation:
+                sources = sourceBit(columnSource(move.from)) | sourceBit(pileSource(move.to));
+                targets = targetBit(FOUNDATIONS) | targetBit(columnTarget(move.from));
+                break;
+            case EngineMove::Type::TableauToTableau:
+                sources = sourceBit(columnSource(move.from)) | sourceBit(columnSource(move.to));
+                targets = targetBit(columnTarget(move.from)) | targetBit(columnTarget(move.to));
+                break;
+            case EngineMove::Type::FoundationToTableau:
+                sources = sourceBit(pileSource(move.from)) | sourceBit(columnSource(move.to));
+                targets = targetBit(FOUNDATIONS) | targetBit(columnTarget(move.to));
+                break;
+        }
+
+        findEmptyColumns(pos);
+        for (uint16_t left = sources; left != 0; left &= left - 1) refreshSource<Rules>(pos, std::countr_zero(left));
+        for (uint8_t left = targets; left != 0; left &= left - 1) {
+            refreshTarget<Rules>(pos, std::countr_zero(left));
+        }
+        refreshStock<Rules>(pos);
+    }
+
+    template <typename Rules>
+    MoveRecord apply(Position& pos, const EngineMove& move) {
+        const MoveRecord record = applyMove<Rules>(pos, move);
+        update<Rules>(pos, move);
+        return record;
+    }
+
+    template <typename Rules>
+    void undo(Position& pos, const MoveRecord& record) {
+        undoMove<Rules>(pos, record);
+        update<Rules>(pos, record.move);
+    }
+
+    // Every legal move, in the order generateMoves gives them; out needs room
+    // for Rules::maxMoves
+    int moves(EngineMove* out) const {
+        int count = 0;
+
+        for (int source = WASTE; source <= columnSource(TABLEAU_COLUMNS - 1); source++) {
+            if (targetMask[source] & targetBit(FOUNDATIONS)) out[count++] = cells[source][FOUNDATIONS];
+        }
+        for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+            const int source = columnSource(col);
+            for (uint8_t left = targetMask[source] & ~targetBit(FOUNDATIONS); left != 0; left &= left - 1) {
+                const int target = std::countr_zero(left);
+                const EngineMove& move = cells[source][target];
+                if (!(runMask[source] & targetBit(target))) {
+                    out[count++] = move;
+                } else if (target == columnTarget(firstEmpty)) {
+                    // Any part of the run may start the first empty column
+                    for (int moved = 1; moved <= move.count; moved++) {
+                        out[count++] = {move.type, move.from, move.to, static_cast<uint8_t>(moved)};
+                    }
+                }
+            }
+        }
+        for (uint8_t left = targetMask[WASTE] & ~targetBit(FOUNDATIONS); left != 0; left &= left - 1) {
+            out[count++] = cells[WASTE][std::countr_zero(left)];
+        }
+        for (int pile = 0; pile < FOUNDATION_PILES; pile++) {
+            const int source = pileSource(pile);
+            for (uint8_t left = targetMask[source]; left != 0; left &= left - 1) {
+                out[count++] = cells[source][std::countr_zero(left)];
+            }
+        }
+        if (hasStockMove) out[count++] = stockMove;
+
+        return count;
+    }
+
+    // Whether the move is legal in the position the cache is up to date
+    // with. Unlike moves(), an Ace may go to any empty foundation pile and
+    // a run to any empty column, as a player may choose.
+    bool isLegal(const Position& pos, const EngineMove& move) const {
+        switch (move.type) {
+            case EngineMove::Type::Draw:
+            case EngineMove::Type::Recycle:
+                return hasStockMove && stockMove.type == move.type;
+            case EngineMove::Type::WasteToFoundation:
+                return move.to < FOUNDATION_PILES && has(WASTE, FOUNDATIONS) &&
+                       buildsOn(pos.wasteTop(), pos.foundation[move.to]);
+            case EngineMove::Type::WasteToTableau:
+                return move.to < TABLEAU_COLUMNS && has(WASTE, columnTarget(move.to));
+            case EngineMove::Type::TableauToFoundation:
+                return move.from < TABLEAU_COLUMNS && move.to < FOUNDATION_PILES && move.count == 1 &&
+                       has(columnSource(move.from), FOUNDATIONS) &&
+                       buildsOn(pos.columnTop(move.from), pos.foundation[move.to]);
+            case EngineMove::Type::TableauToTableau: {
+                if (move.from >= TABLEAU_COLUMNS || move.to >= TABLEAU_COLUMNS) return false;
+                const int source = columnSource(move.from);
+                const int target = columnTarget(move.to);
+                if (!has(source, target)) return false;
+                const uint8_t count = cells[source][target].count;
+                return (runMask[source] & targetBit(target)) ? move.count >= 1 && move.count <= count : move.count == count;
+            }
+            case EngineMove::Type::FoundationToTableau:
+                return move.from < FOUNDATION_PILES && move.to < TABLEAU_COLUMNS &&
+                       has(pileSource(move.from), columnTarget(move.to));
+        }
+        return false;
+    }
+
+private:
+    // Rows: the waste, each column, each foundation pile. Columns of the
+    // table: the foundations as one target, since the pile follows from the
+    // card, then each tableau column.
+    static constexpr int WASTE = 0;
+    static constexpr int SOURCES = 1 + TABLEAU_COLUMNS + FOUNDATION_PILES;
+    static constexpr int FOUNDATIONS = 0;
+    static constexpr int TARGETS = 1 + TABLEAU_COLUMNS;
+    static_assert(TARGETS <= 8 && SOURCES <= 16, "masks hold a bit per target and per source");
+
+    std::array<std::array<EngineMove, TARGETS>, SOURCES> cells{};
+    std::array<uint8_t, SOURCES> targetMask{}; // bit t: cells[source][t] holds a legal move
+    std::array<uint8_t, SOURCES> runMask{};    // bit t: any count up to the cell's may be moved
+    EngineMove stockMove;
+    bool hasStockMove = false;
+    uint8_t emptyColumns = 0; // bit per empty column
+    int firstEmpty = -1;
+
+    static constexpr int columnSource(const int col) {
+        return 1 + col;
+    }
+
+    static constexpr int pileSource(const int pile) {
+        return 1 + TABLEAU_COLUMNS + pile;
+    }
+
+    static constexpr int columnTarget(const int col) {
+        return 1 + col;
+    }
+
+    static constexpr uint16_t sourceBit(const int source) {
+        return static_cast<uint16_t>(1u << source);
+    }
+
+    static constexpr uint8_t targetBit(const int target) {
+        return static_cast<uint8_t>(1u << target);
+    }
+
+    void findEmptyColumns(const Position& pos) {
+        emptyColumns = 0;
+        for (int col = 0; col < TABLEAU_COLUMNS; col++) emptyColumns |= static_cast<uint8_t>((pos.columnSize[col] == 0) << col);
+        firstEmpty = emptyColumns ? std::countr_zero(emptyColumns) : -1;
+    }
+
+    bool has(const int source, const int target) const {
+        return (targetMask[source] & targetBit(target)) != 0;
+    }
+
+    // Adds a cell whose bits are clear
+    void set(const int source, const int target, const EngineMove& move, const bool run = false) {
+        cells[source][target] = move;
+        targetMask[source] |= targetBit(target);
+        if (run) runMask[source] |= targetBit(target);
+    }
+
+    // The same rules as generateMoves: cards a column moves to another one,
+    // 0 if none. With any-card empty columns the answer is the whole run,
+    // of which any part may go.
+    template <typename Rules>
+    static int movedToColumn(const Position& pos, const int from, const int to, const CardId onto) {
+        const int faceUp = pos.countFaceUp(from);
+        if (faceUp == 0 || from == to) return 0;
+        if (Rules::anyCardStartsColumn && onto == NO_CARD) return faceUp;
+
+        const int wantedRank = onto == NO_CARD ? 13 : rankValue(onto) - 1;
+        const int moved = wantedRank - rankValue(pos.columnTop(from)) + 1;
+        if (moved < 1 || moved > faceUp) return 0;
+        if (onto != NO_CARD && !stacksOn(pos.tableau[from][pos.columnSize[from] - moved], onto)) return 0;
+        return moved;
+    }
+
+    template <typename Rules>
+    static bool acceptedBy(const CardId card, const CardId onto) {
+        return onto == NO_CARD ? Rules::canStartColumn(card) : stacksOn(card, onto);
+    }
+
+    // Card a source would play to a foundation: the waste top, or a column's
+    // face-up top
+    static CardId foundationCandidate(const Position& pos, const int source) {
+        if (source == WASTE) return pos.wasteTop();
+        const int col = source - columnSource(0);
+        return pos.countFaceUp(col) > 0 ? pos.columnTop(col) : NO_CARD;
+    }
+
+    template <typename Rules>
+    void refreshSource(const Position& pos, const int source) {
+        using Type = EngineMove::Type;
+
+        // The row's masks are built here and stored once; the cells of
+        // targets left out keep stale moves that nothing reads
+        uint8_t found = 0;
+        uint8_t runs = 0;
+        const auto put = [this, source, &found](const int target, const EngineMove& move) {
+            cells[source][target] = move;
+            found |= targetBit(target);
+        };
+
+        if (source >= pileSource(0)) {
+            const int pile = source - pileSource(0);
+            const CardId card = pos.foundation[pile];
+            if (Rules::foundationToTableau && card != NO_CARD) {
+                for (int to = 0; to < TABLEAU_COLUMNS; to++) {
+                    if (acceptedBy<Rules>(card, pos.columnTop(to))) {
+                        put(columnTarget(to), {Type::FoundationToTableau, static_cast<uint8_t>(pile), static_cast<uint8_t>(to), 1});
+                    }
+                }
+            }
+            targetMask[source] = found;
+            runMask[source] = 0;
+            return;
+        }
+
+        const CardId top = source == WASTE ? pos.wasteTop() : foundationCandidate(pos, source);
+        const int pile = top == NO_CARD ? -1 : pos.foundationFor(top);
+        if (pile >= 0) {
+            put(FOUNDATIONS, {source == WASTE ? Type::WasteToFoundation : Type::TableauToFoundation,
+                              static_cast<uint8_t>(source == WASTE ? 0 : source - columnSource(0)), static_cast<uint8_t>(pile), 1});
+        }
+
+        // Rows with no move to a column are ruled out from the masks first:
+        // random positions make the per-column checks branch unpredictably
+        if (source == WASTE) {
+            if (top != NO_CARD && ((stackTargets(top) & pos.tops) || (emptyColumns && Rules::canStartColumn(top)))) {
+                for (int to = 0; to < TABLEAU_COLUMNS; to++) {
+                    if (acceptedBy<Rules>(top, pos.columnTop(to))) put(columnTarget(to), {Type::WasteToTableau, 0, static_cast<uint8_t>(to), 1});
+                }
+            }
+            targetMask[source] = found;
+            runMask[source] = 0;
+            return;
+        }
+
+        // The ranks the run could go on against the ranks of the tops; suits
+        // are checked per column
+        const int from = source - columnSource(0);
+        const int faceUp = pos.countFaceUp(from);
+        const int lowest = top == NO_CARD ? 0 : rankValue(top);
+        const CardMask reachable = (((CardMask{1} << faceUp) - 1) << lowest) & SUIT_RANKS;
+        const CardMask reachableTops = pos.tops & (reachable | reachable << 13 | reachable << 26 | reachable << 39);
+        const bool toEmpty = emptyColumns && faceUp && (Rules::anyCardStartsColumn || lowest + faceUp - 1 == 13);
+        if (reachableTops || toEmpty) {
+            for (int to = 0; to < TABLEAU_COLUMNS; to++) {
+                const CardId onto = pos.columnTop(to);
+                if (onto == NO_CARD ? !toEmpty : !(reachableTops & cardBit(onto))) continue;
+                const int moved = movedToColumn<Rules>(pos, from, to, onto);
+                if (moved == 0) continue;
+                put(columnTarget(to), {Type::TableauToTableau, static_cast<uint8_t>(from), static_cast<uint8_t>(to), static_cast<uint8_t>(moved)});
+                // Any-card runs are kept for every empty column; moves() offers only the first
+                if (Rules::anyCardStartsColumn && onto == NO_CARD) runs |= targetBit(columnTarget(to));
+            }
+        }
+        targetMask[source] = found;
+        runMask[source] = runs;
+    }
+
+    // One target for every source. Few cards fit a target, so the cells are
+    // cleared and only the sources holding one of those cards are looked at.
+    template <typename Rules>
+    void refreshTarget(const Position& pos, const int target) {
+        using Type = EngineMove::Type;
+        constexpr CardMask KINGS = ACES << 12;
+
+        const uint8_t bit = targetBit(target);
+        for (int source = 0; source < SOURCES; source++) {
+            targetMask[source] &= static_cast<uint8_t>(~bit);
+            runMask[source] &= static_cast<uint8_t>(~bit);
+        }
+        const CardId wasteCard = pos.wasteTop();
+        const CardMask waste = wasteCard == NO_CARD ? 0 : cardBit(wasteCard);
+
+        if (target == FOUNDATIONS) {
+            // At most the next card of each suit, found where it lies
+            for (CardMask playable = pos.foundationNext() & ((pos.tops & pos.faceUp) | waste); playable != 0; playable &= playable - 1) {
+                const auto card = static_cast<CardId>(std::countr_zero(playable));
+                const auto pile = static_cast<uint8_t>(pos.foundationFor(card));
+                if (card == wasteCard) {
+                    set(WASTE, target, {Type::WasteToFoundation, 0, pile, 1});
+                    continue;
+                }
+                for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+                    if (pos.columnTop(col) == card) set(columnSource(col), target, {Type::TableauToFoundation, static_cast<uint8_t>(col), pile, 1});
+                }
+            }
+            return;
+        }
+
+        const auto to = static_cast<uint8_t>(target - 1);
+        const CardId onto = pos.columnTop(to);
+        const CardMask wanted = onto == NO_CARD ? (Rules::anyCardStartsColumn ? ALL_CARDS : KINGS) : stackableOn(cardBit(onto));
+
+        if (waste & wanted) set(WASTE, target, {Type::WasteToTableau, 0, to, 1});
+        if (pos.faceUp & wanted) {
+            for (int from = 0; from < TABLEAU_COLUMNS; from++) {
+                const int moved = movedToColumn<Rules>(pos, from, to, onto);
+                if (moved > 0) {
+                    set(columnSource(from), target,
+                        {Type::TableauToTableau, static_cast<uint8_t>(from), to, static_cast<uint8_t>(moved)},
+                        Rules::anyCardStartsColumn && onto == NO_CARD);
+                }
+            }
+        }
+        for (int pile = 0; Rules::foundationToTableau && pile < FOUNDATION_PILES; pile++) {
+            const CardId card = pos.foundation[pile];
+            if (card != NO_CARD && (wanted & cardBit(card))) {
+                set(pileSource(pile), target, {Type::FoundationToTableau, static_cast<uint8_t>(pile), to, 1});
+            }
+        }
+    }
+
+    template <typename Rules>
+    void refreshStock(const Position& pos) {
+        hasStockMove = true;
+        if (!pos.stockEmpty()) {
+            stockMove = {EngineMove::Type::Draw, 0, 0, 1};
+        } else if (!pos.wasteEmpty() && Rules::canRecycle(pos.recycles)) {
+            stockMove = {EngineMove::Type::Recycle, 0, 0, 1};
+        } else {
+            hasStockMove = false;
+        }
+    }
+};
+
+#endif // MOVECACHE_H
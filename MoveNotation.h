@@ -0,0 +1,101 @@
+#ifndef MOVENOTATION_H
+#define MOVENOTATION_H
+
+#include <string>
+#include <string_view>
+
+#include "Position.h"
+
+// Text form of cards and engine moves for logs, files and tools.
+//
+// Cards are rank then suit: "AH", "TD", "QS". Moves use 0-based pile
+// indices: "D" draw, "R" recycle, "W>F0", "W>T3", "T2>F1", "T2>T5",
+// "T2>T5x3" (three cards), "F1>T3".
+
+inline std::string cardToString(const CardId card) {
+    if (card == NO_CARD) return "--";
+    constexpr std::string_view ranks = "A23456789TJQK";
+    constexpr std::string_view suits = "HDCS";
+    return {ranks[card % 13], suits[card / 13]};
+}
+
+inline std::string moveToString(const EngineMove& move) {
+    const auto pile = [](const char kind, const int index) {
+        return std::string{kind, static_cast<char>('0' + index)};
+    };
+
+    switch (move.type) {
+        case EngineMove::Type::Draw:                return "D";
+        case EngineMove::Type::Recycle:             return "R";
+        case EngineMove::Type::WasteToFoundation:   return "W>" + pile('F', move.to);
+        case EngineMove::Type::WasteToTableau:      return "W>" + pile('T', move.to);
+        case EngineMove::Type::TableauToFoundation: return pile('T', move.from) + ">" + pile('F', move.to);
+        case EngineMove::Type::FoundationToTableau: return pile('F', move.from) + ">" + pile('T', move.to);
+        case EngineMove::Type::TableauToTableau: {
+            std::string text = pile('T', move.from) + ">" + pile('T', move.to);
+            if (move.count > 1) text += "x" + std::to_string(move.count);
+            return text;
+        }
+    }
+    return "?";
+}
+
+// Parses moveToString output; indices are range-checked, legality is not
+inline bool parseMove(const std::string_view text, EngineMove& move) {
+    using Type = EngineMove::Type;
+
+    if (text == "D") {
+        move = {Type::Draw, 0, 0, 1};
+        return true;
+    }
+    if (text == "R") {
+        move = {Type::Recycle, 0, 0, 1};
+        return true;
+    }
+
+    // Source: "W" or kind + digit, then ">" and kind + digit
+    const size_t arrow = text.find('>');
+    if (arrow == std::string_view::npos || arrow + 3 > text.size()) return false;
+    const std::string_view source = text.substr(0, arrow);
+    const char destKind = text[arrow + 1];
+    const int to = text[arrow + 2] - '0';
+
+    std::string_view rest = text.substr(arrow + 3);
+    int count = 1;
+    if (!rest.empty()) {
+        if (rest[0] != 'x' || rest.size() < 2 || rest.size() > 3) return false;
+        count = 0;
+        for (const char c : rest.substr(1)) {
+            if (c < '0' || c > '9') return false;
+            count = count * 10 + (c - '0');
+        }
+        if (count < 1 || count > 13) return false;
+    }
+
+    const bool toFoundation = destKind == 'F' && to >= 0 && to < FOUNDATION_PILES;
+    const bool toTableau = destKind == 'T' && to >= 0 && to < TABLEAU_COLUMNS;
+    if (!toFoundation && !toTableau) return false;
+
+    if (source == "W") {
+        if (count != 1) return false;
+        move = {toFoundation ? Type::WasteToFoundation : Type::WasteToTableau, 0, static_cast<uint8_t>(to), 1};
+        return true;
+    }
+
+    if (source.size() != 2) return false;
+    const int from = source[1] - '0';
+
+    if (source[0] == 'T' && from >= 0 && from < TABLEAU_COLUMNS) {
+        if (toFoundation && count != 1) return false;
+        move = {toFoundation ? Type::TableauToFoundation : Type::TableauToTableau, static_cast<uint8_t>(from),
+                static_cast<uint8_t>(to), static_cast<uint8_t>(count)};
+        return true;
+    }
+    if (source[0] == 'F' && from >= 0 && from < FOUNDATION_PILES && toTableau && count == 1) {
+        move = {Type::FoundationToTableau, static_cast<uint8_t>(from), static_cast<uint8_t>(to), 1};
+        return true;
+    }
+    return false;
+}
+
+#endif // MOVENOTATION_H
@@ -0,0 +1,71 @@
+#ifndef PARALLELSOLVER_H
+#define PARALLELSOLVER_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Solver.h"
+#include "TranspositionTable.h"
+
+// Several Solver threads search the same deal and share one visited table.
+// Thread 0 keeps the normal move order, the others shuffle theirs, so they
+// spread over different parts of the tree and skip what is already covered.
+// The first solution stops everyone; the deal is unsolvable only if every
+// thread finishes its search.
+template <typename Rules>
+class ParallelSolver {
+public:
+    ParallelSolver(TranspositionTable& table, const SolverOptions& options, const int threads)
+        : table(table), options(options), threads(std::max(1, threads)) {}
+
+    SolverOutcome solve(const Position& start) {
+        table.newSearch();
+
+        std::atomic<bool> stop{false};
+        std::vector<SolverOutcome> outcomes(threads);
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back([&, i] {
+                SolverOptions threadOptions = options;
+                threadOptions.table = &table;
+                threadOptions.stop = &stop;
+                threadOptions.orderSeed = i == 0 ? 0 : 0x9e3779b9u * static_cast<uint32_t>(i);
+
+                outcomes[i] = Solver<Rules>(threadOptions).solve(start);
+                if (outcomes[i].result == SolveResult::Solved) {
+                    stop.store(true, std::memory_order_relaxed);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        SolverOutcome combined;
+        combined.result = SolveResult::Unsolvable;
+        for (SolverOutcome& outcome : outcomes) {
+            combined.stats.nodes += outcome.stats.nodes;
+            combined.stats.transpositions += outcome.stats.transpositions;
+            combined.stats.memoryBytes += outcome.stats.memoryBytes;
+            combined.stats.maxDepth = std::max(combined.stats.maxDepth, outcome.stats.maxDepth);
+
+            if (outcome.result == SolveResult::Solved && combined.result != SolveResult::Solved) {
+                combined.result = SolveResult::Solved;
+                combined.solution = std::move(outcome.solution);
+            } else if (outcome.result == SolveResult::Unknown && combined.result == SolveResult::Unsolvable) {
+                combined.result = SolveResult::Unknown;
+            }
+        }
+        return combined;
+    }
+
+private:
+    TranspositionTable& table;
+    SolverOptions options;
+    int threads;
+};
+
+#endif // PARALLELSOLVER_H
@@ -0,0 +1,559 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <utility>
+
+#include "CardTypes.h"
+
+// Compact, headless Klondike state for search, replay and tooling.
+// Cards are ids 0..51 laid out as suit * 13 + rank - 1, so the two red
+// suits come first and the next card of a suit is always id + 1.
+using CardId = uint8_t;
+
+constexpr CardId NO_CARD = 0xFF;
+constexpr int DECK_SIZE = 52;
+constexpr int TABLEAU_COLUMNS = 7;
+constexpr int FOUNDATION_PILES = 4;
+constexpr int MAX_COLUMN_CARDS = 19; // 6 face-down cards under a full King..Ace run
+constexpr int STOCK_CARDS = 24;
+constexpr int MAX_MOVES = 96; // with Kings-only empty columns, see KlondikeRules::maxMoves
+
+constexpr CardId makeCard(const Suit suit, const Rank rank) {
+    return static_cast<CardId>(static_cast<int>(suit) * 13 + static_cast<int>(rank) - 1);
+}
+
+// Lets engine code written for piles of Card also read CardIds
+constexpr CardId toCardId(const CardId card) {
+    return card;
+}
+
+constexpr Suit cardSuit(const CardId card) {
+    return static_cast<Suit>(card / 13);
+}
+
+constexpr Rank cardRank(const CardId card) {
+    return static_cast<Rank>(card % 13 + 1);
+}
+
+constexpr int rankValue(const CardId card) {
+    return card % 13 + 1;
+}
+
+constexpr bool isRedCard(const CardId card) {
+    return card < 26;
+}
+
+// Tableau rule: card goes onto a card of the opposite colour one rank higher
+constexpr bool stacksOn(const CardId card, const CardId onto) {
+    return isRedCard(card) != isRedCard(onto) && rankValue(card) + 1 == rankValue(onto);
+}
+
+// Foundation rule: Ace on an empty pile, otherwise the next card of the same suit
+constexpr bool buildsOn(const CardId card, const CardId top) {
+    return top == NO_CARD ? rankValue(card) == 1 : card == top + 1 && rankValue(top) != 13;
+}
+
+// A set of cards, bit n for card id n. With the ids laid out by suit the
+// rules become shifts: the next card of a suit is the next bit, and a suit
+// is a 13-bit field.
+using CardMask = uint64_t;
+
+constexpr CardMask ALL_CARDS = (CardMask{1} << DECK_SIZE) - 1;
+constexpr CardMask SUIT_RANKS = 0x1FFF;
+constexpr CardMask ACES = CardMask{1} | CardMask{1} << 13 | CardMask{1} << 26 | CardMask{1} << 39;
+
+constexpr CardMask cardBit(const CardId card) {
+    return CardMask{1} << card;
+}
+
+// The two cards the card may be stacked on: opposite colour, one rank higher
+constexpr CardMask stackTargets(const CardId card) {
+    if (rankValue(card) == 13) return 0;
+    const int above = card % 13 + 1;
+    return isRedCard(card) ? cardBit(static_cast<CardId>(26 + above)) | cardBit(static_cast<CardId>(39 + above))
+                           : cardBit(static_cast<CardId>(above)) | cardBit(static_cast<CardId>(13 + above));
+}
+
+// Every card that may be stacked on one of the given cards
+constexpr CardMask stackableOn(const CardMask cards) {
+    const CardMask redRanks = (cards | cards >> 13) & SUIT_RANKS;
+    const CardMask blackRanks = (cards >> 26 | cards >> 39) & SUIT_RANKS;
+    const CardMask onRed = redRanks >> 1;   // black, a rank lower
+    const CardMask onBlack = blackRanks >> 1; // red, a rank lower
+    return onBlack | onBlack << 13 | onRed << 26 | onRed << 39;
+}
+
+static_assert(stackableOn(cardBit(makeCard(Suit::Hearts, Rank::Seven))) ==
+              (cardBit(makeCard(Suit::Clubs, Rank::Six)) | cardBit(makeCard(Suit::Spades, Rank::Six))));
+static_assert((stackTargets(makeCard(Suit::Clubs, Rank::Six)) & cardBit(makeCard(Suit::Hearts, Rank::Seven))) != 0);
+
+struct Position {
+    // Card sets kept up to date by dealPosition, applyMove and undoMove, so
+    // rule checks and the win test are a few bitwise operations
+    CardMask faceUp = 0;        // face-up tableau cards
+    CardMask faceDownCards = 0; // face-down tableau cards
+    CardMask onFoundation = 0;  // cards on the foundations
+    CardMask tops = 0;          // top card of each non-empty column
+
+    std::array<std::array<CardId, MAX_COLUMN_CARDS>, TABLEAU_COLUMNS> tableau{};
+    std::array<uint8_t, TABLEAU_COLUMNS> columnSize{};
+    std::array<uint8_t, TABLEAU_COLUMNS> faceDown{};
+    std::array<CardId, FOUNDATION_PILES> foundation{NO_CARD, NO_CARD, NO_CARD, NO_CARD}; // top card per pile
+    std::array<CardId, STOCK_CARDS> stock{}; // stock and waste split by cursor, as in StockPile
+    uint8_t stockSize = 0;
+    uint8_t cursor = 0;
+    uint8_t recycles = 0; // waste turned back into stock, counted only under limited passes
+    uint8_t unused[6]{};  // explicit, so equal positions are equal bytes
+
+    CardId columnTop(const int column) const {
+        return columnSize[column] ? tableau[column][columnSize[column] - 1] : NO_CARD;
+    }
+
+    int countFaceUp(const int column) const {
+        return columnSize[column] - faceDown[column];
+    }
+
+    CardId wasteTop() const {
+        return cursor ? stock[cursor - 1] : NO_CARD;
+    }
+
+    bool stockEmpty() const {
+        return cursor == stockSize;
+    }
+
+    bool wasteEmpty() const {
+        return cursor == 0;
+    }
+
+    // Cards of the given suit already on the foundations
+    int foundationLevel(const Suit suit) const {
+        return std::popcount((onFoundation >> (static_cast<int>(suit) * 13)) & SUIT_RANKS);
+    }
+
+    // The next card of every suit not yet complete
+    CardMask foundationNext() const {
+        return ((onFoundation << 1) | ACES) & ~onFoundation & ALL_CARDS;
+    }
+
+    // Cards that can be played: the face-up tableau and the waste top
+    CardMask available() const {
+        return wasteEmpty() ? faceUp : faceUp | cardBit(wasteTop());
+    }
+
+    // Cards some non-empty column would take
+    CardMask acceptedByTops() const {
+        return stackableOn(tops);
+    }
+
+    // Pile the card can be played to, first empty pile for an Ace, -1 if none
+    int foundationFor(const CardId card) const {
+        if (!(foundationNext() & cardBit(card))) return -1;
+        for (int i = 0; i < FOUNDATION_PILES; i++) {
+            if (buildsOn(card, foundation[i])) return i;
+        }
+        return -1;
+    }
+
+    int cardsOnFoundations() const {
+        return std::popcount(onFoundation);
+    }
+
+    bool isWin() const {
+        return onFoundation == ALL_CARDS;
+    }
+};
+
+// Saves and tests compare positions byte for byte
+static_assert(std::has_unique_object_representations_v<Position>);
+
+struct EngineMove {
+    enum class Type : uint8_t {
+        Draw,
+        Recycle,
+        WasteToFoundation,
+        WasteToTableau,
+        TableauToFoundation,
+        TableauToTableau,
+        FoundationToTableau
+    } type = Type::Draw;
+
+    uint8_t from = 0;  // tableau column or foundation pile
+    uint8_t to = 0;    // tableau column or foundation pile
+    uint8_t count = 1; // cards moved between tableau columns
+
+    bool operator==(const EngineMove&) const = default;
+};
+
+static_assert(sizeof(EngineMove) == 4);
+
+// What applyMove needs to remember so undoMove can reverse it
+struct MoveRecord {
+    EngineMove move;
+    uint8_t prevCursor = 0;
+    bool flipped = false;
+};
+
+// Seeded Fisher-Yates. Written out rather than std::shuffle so a seed deals
+// the same cards with every standard library.
+inline std::array<CardId, DECK_SIZE> shuffledDeck(const uint64_t seed) {
+    std::array<CardId, DECK_SIZE> deck{};
+    for (int i = 0; i < DECK_SIZE; i++) {
+        deck[i] = static_cast<CardId>(i);
+    }
+
+    std::mt19937_64 rng(seed);
+    for (int i = DECK_SIZE - 1; i > 0; i--) {
+        const auto j = static_cast<int>(rng() % static_cast<uint64_t>(i + 1));
+        std::swap(deck[i], deck[j]);
+    }
+    return deck;
+}
+
+// Deals like SolitaireGame: column i gets i + 1 cards with only the last one
+// face up, the remaining 24 cards form the stock in deck order.
+inline Position dealPosition(const uint64_t seed) {
+    const auto deck = shuffledDeck(seed);
+    Position pos;
+
+    int index = 0;
+    for (int i = 0; i < TABLEAU_COLUMNS; i++) {
+        for (int j = 0; j <= i; j++) {
+            pos.tableau[i][j] = deck[index++];
+        }
+        pos.columnSize[i] = static_cast<uint8_t>(i + 1);
+        pos.faceDown[i] = static_cast<uint8_t>(i);
+        for (int j = 0; j < i; j++) pos.faceDownCards |= cardBit(pos.tableau[i][j]);
+        pos.faceUp |= cardBit(pos.tableau[i][i]);
+        pos.tops |= cardBit(pos.tableau[i][i]);
+    }
+
+    while (index < DECK_SIZE) {
+        pos.stock[pos.stockSize++] = deck[index++];
+    }
+
+    return pos;
+}
+
+// The move functions below take a rule set from Rules.h, e.g.
+// applyMove<Draw3Rules>(pos, move)
+template <typename Rules>
+bool isLegalMove(const Position& pos, const EngineMove& move) {
+    switch (move.type) {
+        case EngineMove::Type::Draw:
+            return !pos.stockEmpty();
+        case EngineMove::Type::Recycle:
+            return pos.stockEmpty() && !pos.wasteEmpty() && Rules::canRecycle(pos.recycles);
+        case EngineMove::Type::WasteToFoundation:
+            return move.to < FOUNDATION_PILES && !pos.wasteEmpty() &&
+                   buildsOn(pos.wasteTop(), pos.foundation[move.to]);
+        case EngineMove::Type::WasteToTableau: {
+            if (move.to >= TABLEAU_COLUMNS || pos.wasteEmpty()) return false;
+            const CardId top = pos.columnTop(move.to);
+            return top == NO_CARD ? Rules::canStartColumn(pos.wasteTop()) : stacksOn(pos.wasteTop(), top);
+        }
+        case EngineMove::Type::TableauToFoundation:
+            return move.from < TABLEAU_COLUMNS && move.to < FOUNDATION_PILES &&
+                   pos.countFaceUp(move.from) > 0 &&
+                   buildsOn(pos.columnTop(move.from), pos.foundation[move.to]);
+        case EngineMove::Type::TableauToTableau: {
+            if (move.from >= TABLEAU_COLUMNS || move.to >= TABLEAU_COLUMNS || move.from == move.to) return false;
+            if (move.count == 0 || move.count > pos.countFaceUp(move.from)) return false;
+
+            const auto& column = pos.tableau[move.from];
+            const int start = pos.columnSize[move.from] - move.count;
+            for (int i = start + 1; i < pos.columnSize[move.from]; i++) {
+                if (!stacksOn(column[i], column[i - 1])) return false;
+            }
+
+            const CardId top = pos.columnTop(move.to);
+            return top == NO_CARD ? Rules::canStartColumn(column[start]) : stacksOn(column[start], top);
+        }
+        case EngineMove::Type::FoundationToTableau: {
+            if (!Rules::foundationToTableau) return false;
+            if (move.from >= FOUNDATION_PILES || move.to >= TABLEAU_COLUMNS) return false;
+            const CardId card = pos.foundation[move.from];
+            if (card == NO_CARD) return false;
+            const CardId top = pos.columnTop(move.to);
+            return top == NO_CARD ? Rules::canStartColumn(card) : stacksOn(card, top);
+        }
+    }
+    return false;
+}
+
+namespace detail {
+    inline uint64_t finalizeHash(uint64_t h) {
+        h ^= h >> 29;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 32;
+        return h;
+    }
+
+    inline void removeWasteTop(Position& pos) {
+        for (int i = pos.cursor; i < pos.stockSize; i++) {
+            pos.stock[i - 1] = pos.stock[i];
+        }
+        pos.cursor--;
+        pos.stockSize--;
+    }
+
+    inline void restoreWasteTop(Position& pos, const CardId card) {
+        for (int i = pos.stockSize; i > pos.cursor; i--) {
+            pos.stock[i] = pos.stock[i - 1];
+        }
+        pos.stock[pos.cursor] = card;
+        pos.cursor++;
+        pos.stockSize++;
+    }
+
+    // Puts a face-up card on a column
+    inline void pushCard(Position& pos, const int column, const CardId card) {
+        const CardId top = pos.columnTop(column);
+        if (top != NO_CARD) pos.tops &= ~cardBit(top);
+        pos.tableau[column][pos.columnSize[column]++] = card;
+        pos.faceUp |= cardBit(card);
+        pos.tops |= cardBit(card);
+    }
+
+    // Takes the face-up cards above the first `size` off a column; size is
+    // below the column's
+    inline void truncateColumn(Position& pos, const int column, const int size) {
+        for (int i = size; i < pos.columnSize[column]; i++) {
+            pos.faceUp &= ~cardBit(pos.tableau[column][i]);
+        }
+        pos.tops &= ~cardBit(pos.columnTop(column));
+        pos.columnSize[column] = static_cast<uint8_t>(size);
+        if (size > 0) pos.tops |= cardBit(pos.tableau[column][size - 1]);
+    }
+
+    // Turns the new top of a column face up, reports whether it had to
+    inline bool flipIfNeeded(Position& pos, const int column) {
+        if (pos.columnSize[column] > 0 && pos.faceDown[column] == pos.columnSize[column]) {
+            pos.faceDown[column]--;
+            pos.faceUp |= cardBit(pos.columnTop(column));
+            pos.faceDownCards &= ~cardBit(pos.columnTop(column));
+            return true;
+        }
+        return false;
+    }
+
+    inline void unflip(Position& pos, const int column) {
+        pos.faceDown[column]++;
+        pos.faceUp &= ~cardBit(pos.columnTop(column));
+        pos.faceDownCards |= cardBit(pos.columnTop(column));
+    }
+
+    inline void pushFoundation(Position& pos, const int pile, const CardId card) {
+        pos.foundation[pile] = card;
+        pos.onFoundation |= cardBit(card);
+    }
+
+    inline CardId popFoundation(Position& pos, const int pile) {
+        const CardId card = pos.foundation[pile];
+        pos.foundation[pile] = rankValue(card) == 1 ? NO_CARD : static_cast<CardId>(card - 1);
+        pos.onFoundation &= ~cardBit(card);
+        return card;
+    }
+}
+
+// Applies a legal move, see isLegalMove
+template <typename Rules>
+MoveRecord applyMove(Position& pos, const EngineMove& move) {
+    MoveRecord record{move, pos.cursor, false};
+
+    switch (move.type) {
+        case EngineMove::Type::Draw:
+            pos.cursor = static_cast<uint8_t>(std::min(pos.cursor + Rules::drawCount, static_cast<int>(pos.stockSize)));
+            break;
+        case EngineMove::Type::Recycle:
+            pos.cursor = 0;
+            if constexpr (Rules::countsRecycles) pos.recycles++;
+            break;
+        case EngineMove::Type::WasteToFoundation:
+            detail::pushFoundation(pos, move.to, pos.wasteTop());
+            detail::removeWasteTop(pos);
+            break;
+        case EngineMove::Type::WasteToTableau:
+            detail::pushCard(pos, move.to, pos.wasteTop());
+            detail::removeWasteTop(pos);
+            break;
+        case EngineMove::Type::TableauToFoundation:
+            detail::pushFoundation(pos, move.to, pos.columnTop(move.from));
+            detail::truncateColumn(pos, move.from, pos.columnSize[move.from] - 1);
+            record.flipped = detail::flipIfNeeded(pos, move.from);
+            break;
+        case EngineMove::Type::TableauToTableau: {
+            // The cards stay in place past the new size while they are copied
+            const int start = pos.columnSize[move.from] - move.count;
+            detail::truncateColumn(pos, move.from, start);
+            for (int i = 0; i < move.count; i++) {
+                detail::pushCard(pos, move.to, pos.tableau[move.from][start + i]);
+            }
+            record.flipped = detail::flipIfNeeded(pos, move.from);
+            break;
+        }
+        case EngineMove::Type::FoundationToTableau:
+            detail::pushCard(pos, move.to, detail::popFoundation(pos, move.from));
+            break;
+    }
+
+    return record;
+}
+
+template <typename Rules>
+void undoMove(Position& pos, const MoveRecord& record) {
+    const EngineMove& move = record.move;
+
+    switch (move.type) {
+        case EngineMove::Type::Draw:
+            pos.cursor = record.prevCursor;
+            break;
+        case EngineMove::Type::Recycle:
+            pos.cursor = record.prevCursor;
+            if constexpr (Rules::countsRecycles) pos.recycles--;
+            break;
+        case EngineMove::Type::WasteToFoundation:
+            detail::restoreWasteTop(pos, detail::popFoundation(pos, move.to));
+            break;
+        case EngineMove::Type::WasteToTableau:
+            detail::restoreWasteTop(pos, pos.columnTop(move.to));
+            detail::truncateColumn(pos, move.to, pos.columnSize[move.to] - 1);
+            break;
+        case EngineMove::Type::TableauToFoundation:
+            if (record.flipped) detail::unflip(pos, move.from);
+            detail::pushCard(pos, move.from, detail::popFoundation(pos, move.to));
+            break;
+        case EngineMove::Type::TableauToTableau: {
+            if (record.flipped) detail::unflip(pos, move.from);
+            const int start = pos.columnSize[move.to] - move.count;
+            detail::truncateColumn(pos, move.to, start);
+            for (int i = 0; i < move.count; i++) {
+                detail::pushCard(pos, move.from, pos.tableau[move.to][start + i]);
+            }
+            break;
+        }
+        case EngineMove::Type::FoundationToTableau: {
+            const CardId card = pos.columnTop(move.to);
+            detail::truncateColumn(pos, move.to, pos.columnSize[move.to] - 1);
+            detail::pushFoundation(pos, move.from, card);
+            break;
+        }
+    }
+}
+
+// Every legal move, foundation moves first and stock moves last. Aces are
+// only offered to the first empty foundation pile.
+template <typename Rules>
+int generateMoves(const Position& pos, EngineMove* out) {
+    int count = 0;
+
+    const CardId waste = pos.wasteTop();
+    if (waste != NO_CARD) {
+        const int pile = pos.foundationFor(waste);
+        if (pile >= 0) out[count++] = {EngineMove::Type::WasteToFoundation, 0, static_cast<uint8_t>(pile), 1};
+    }
+
+    for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+        if (pos.countFaceUp(col) == 0) continue;
+        const int pile = pos.foundationFor(pos.columnTop(col));
+        if (pile >= 0) {
+            out[count++] = {EngineMove::Type::TableauToFoundation, static_cast<uint8_t>(col), static_cast<uint8_t>(pile), 1};
+        }
+    }
+
+    int firstEmpty = -1;
+    for (int col = TABLEAU_COLUMNS - 1; col >= 0; col--) {
+        if (pos.columnSize[col] == 0) firstEmpty = col;
+    }
+
+    for (int from = 0; from < TABLEAU_COLUMNS; from++) {
+        const int faceUp = pos.countFaceUp(from);
+        if (faceUp == 0) continue;
+
+        const int size = pos.columnSize[from];
+        const CardId top = pos.columnTop(from);
+
+        for (int to = 0; to < TABLEAU_COLUMNS; to++) {
+            if (to == from) continue;
+
+            const CardId target = pos.columnTop(to);
+            if (Rules::anyCardStartsColumn && target == NO_CARD) {
+                // Any part of the run may start an empty column. Empty columns
+                // are interchangeable, so only the first is offered.
+                if (to != firstEmpty) continue;
+                for (int moved = 1; moved <= faceUp; moved++) {
+                    out[count++] = {EngineMove::Type::TableauToTableau, static_cast<uint8_t>(from),
+                                    static_cast<uint8_t>(to), static_cast<uint8_t>(moved)};
+                }
+                continue;
+            }
+
+            // Ranks in the face-up run drop by one per card, so the only
+            // candidate start is found by arithmetic
+            const int wantedRank = target == NO_CARD ? 13 : rankValue(target) - 1;
+            const int moved = wantedRank - rankValue(top) + 1;
+            if (moved < 1 || moved > faceUp) continue;
+
+            const CardId start = pos.tableau[from][size - moved];
+            if (target != NO_CARD && !stacksOn(start, target)) continue;
+
+            out[count++] = {EngineMove::Type::TableauToTableau, static_cast<uint8_t>(from), static_cast<uint8_t>(to),
+                            static_cast<uint8_t>(moved)};
+        }
+    }
+
+    // Whether some top takes the waste card is one lookup; only then is the
+    // column searched for
+    if (waste != NO_CARD && ((pos.acceptedByTops() & cardBit(waste)) || firstEmpty >= 0)) {
+        for (int to = 0; to < TABLEAU_COLUMNS; to++) {
+            const CardId target = pos.columnTop(to);
+            if (target == NO_CARD ? Rules::canStartColumn(waste) : stacksOn(waste, target)) {
+                out[count++] = {EngineMove::Type::WasteToTableau, 0, static_cast<uint8_t>(to), 1};
+            }
+        }
+    }
+
+    for (int pile = 0; Rules::foundationToTableau && pile < FOUNDATION_PILES; pile++) {
+        const CardId card = pos.foundation[pile];
+        if (card == NO_CARD) continue;
+        for (int to = 0; to < TABLEAU_COLUMNS; to++) {
+            const CardId target = pos.columnTop(to);
+            if (target == NO_CARD ? Rules::canStartColumn(card) : stacksOn(card, target)) {
+                out[count++] = {EngineMove::Type::FoundationToTableau, static_cast<uint8_t>(pile), static_cast<uint8_t>(to), 1};
+            }
+        }
+    }
+
+    if (!pos.stockEmpty()) {
+        out[count++] = {EngineMove::Type::Draw, 0, 0, 1};
+    } else if (!pos.wasteEmpty() && Rules::canRecycle(pos.recycles)) {
+        out[count++] = {EngineMove::Type::Recycle, 0, 0, 1};
+    }
+
+    return count;
+}
+
+// Order-dependent hash of the exact position
+inline uint64_t positionHash(const Position& pos) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    const auto mix = [&h](const uint64_t value) {
+        h = (h ^ value) * 0x100000001b3ULL;
+    };
+
+    for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+        mix(0x100 | pos.faceDown[col]);
+        for (int i = 0; i < pos.columnSize[col]; i++) mix(pos.tableau[col][i]);
+    }
+    for (const CardId top : pos.foundation) mix(0x200 | top);
+    mix(0x300 | pos.cursor | (pos.recycles << 16));
+    for (int i = 0; i < pos.stockSize; i++) mix(pos.stock[i]);
+
+    return detail::finalizeHash(h);
+}
+
+#endif // POSITION_H
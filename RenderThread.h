@@ -0,0 +1,125 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+
+// Three frames shared by one writer and one reader without locks. The writer
+// fills its back frame and publishes it; the reader takes the newest
+// published frame. A frame published again before the reader took the
+// previous one replaces it, so a slow reader skips stale frames instead of
+// queueing them, and neither side ever waits for the other.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& back() {
+        return slots[backIndex];
+    }
+
+    void publish() {
+        backIndex = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader side: false if nothing new was published since the last call
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T& front() const {
+        return slots[frontIndex];
+    }
+
+private:
+    static constexpr uint8_t INDEX = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    std::array<T, 3> slots{};
+    uint8_t backIndex = 0;
+    uint8_t frontIndex = 1;
+    std::atomic<uint8_t> middle{2};
+};
+
+// Writes frames out on its own thread, so the thread producing them never
+// blocks on console or terminal I/O. The producer fills frame() and calls
+// submit(); the render thread presents the newest submitted frame and
+// drops any it had no time for.
+template <typename Frame>
+class RenderThread {
+public:
+    using Present = std::function<void(const Frame&)>;
+
+    explicit RenderThread(Present present) : present(std::move(present)) {
+        worker = std::thread([this] { run(); });
+    }
+
+    // Presents the last submitted frame, if still pending, then stops
+    ~RenderThread() {
+        stopping.store(true, std::memory_order_relaxed);
+        submitted.fetch_add(1, std::memory_order_release);
+        submitted.notify_one();
+        worker.join();
+    }
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // The frame to fill next; stays the producer's until submit()
+    Frame& frame() {
+        return frames.back();
+    }
+
+    void submit() {
+        frames.publish();
+        submitted.fetch_add(1, std::memory_order_release);
+        submitted.notify_one();
+    }
+
+    uint32_t framesPresented() const {
+        return presented.load(std::memory_order_relaxed);
+    }
+
+    // Blocks until every frame submitted so far is on screen, or was
+    // dropped for a newer one that is
+    void flush() {
+        const uint32_t target = submitted.load(std::memory_order_acquire);
+        for (uint32_t done = caughtUp.load(std::memory_order_acquire);
+             static_cast<int32_t>(done - target) < 0;
+             done = caughtUp.load(std::memory_order_acquire)) {
+            caughtUp.wait(done, std::memory_order_acquire);
+        }
+    }
+
+private:
+    Present present;
+    TripleBuffer<Frame> frames;
+    std::atomic<uint32_t> submitted{0};
+    std::atomic<uint32_t> presented{0};
+    std::atomic<uint32_t> caughtUp{0}; // submissions seen before the last present finished
+    std::atomic<bool> stopping{false};
+    std::thread worker;
+
+    void run() {
+        uint32_t seen = 0;
+        while (true) {
+            submitted.wait(seen, std::memory_order_acquire);
+            seen = submitted.load(std::memory_order_acquire);
+
+            if (frames.acquire()) {
+                present(frames.front());
+                presented.fetch_add(1, std::memory_order_relaxed);
+            }
+            caughtUp.store(seen, std::memory_order_release);
+            caughtUp.notify_all();
+            if (stopping.load(std::memory_order_relaxed)) return;
+        }
+    }
+};
+
+#endif // RENDERTHREAD_H
@@ -5,9 +5,29 @@
 #ifndef RENDERABLE_H
 #define RENDERABLE_H
 
+#include <algorithm>
+
 #include "ConsoleColors.h"
 #include "ScreenBuffer.h"
 
+// Screen area in cells
+struct Rect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool empty() const {
+        return width <= 0 || height <= 0;
+    }
+
+    bool intersects(const Rect& other) const {
+        return !empty() && !other.empty() &&
+               x < other.x + other.width && other.x < x + width &&
+               y < other.y + other.height && other.y < y + height;
+    }
+};
+
 class Renderable {
 public:
     int posX;
@@ -18,13 +38,54 @@ public:
     Renderable(const int width, const int height): posX(0), posY(0), width(width), height(height) {};
 
     void setSize(const int width, const int height) {
+        if (width == this->width && height == this->height) return;
         this->width = width;
         this->height = height;
+        markDirty();
     }
 
     void setPos(const int x, const int y) {
+        if (x == posX && y == posY) return;
         posX = x;
         posY = y;
+        markDirty();
+    }
+
+    // Area the node paints; nodes that draw past their size report more
+    Rect bounds() const {
+        return {posX, posY, width, height};
+    }
+
+    // Retained drawing: whatever changes how a node looks marks it dirty,
+    // and only dirty nodes are drawn again (see Scene.h)
+    void markDirty() {
+        dirty = true;
+    }
+
+    bool isDirty() const {
+        return dirty;
+    }
+
+    // Area covered by the last draw, to be painted over when the node moves or shrinks
+    const Rect& drawnArea() const {
+        return drawn;
+    }
+
+    void markDrawn(const Rect& area) {
+        drawn = area;
+        dirty = false;
+    }
+
+    // Paints a screen area, clipped to the screen
+    static void fill(ScreenBuffer& screen, const Rect& area, const WORD color) {
+        const int top = std::max(0, area.y), bottom = std::min<int>(screen.height, area.y + area.height);
+        const int left = std::max(0, area.x), right = std::min<int>(screen.width, area.x + area.width);
+        for (int y = top; y < bottom; y++) {
+            for (int x = left; x < right; x++) {
+                screen.buffer[y * screen.width + x].Char.UnicodeChar = L' ';
+                screen.buffer[y * screen.width + x].Attributes = color;
+            }
+        }
     }
 
     void clear(ScreenBuffer& screen, WORD color = FG_WHITE) const {
@@ -97,6 +158,9 @@ public:
         }
     }
 
+private:
+    bool dirty = true;
+    Rect drawn;
 };
 
 #endif //RENDERABLE_H
@@ -0,0 +1,96 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "Position.h"
+
+enum class EmptyColumnRule {
+    KingsOnly, // only a King (or a run headed by one) may fill an empty column
+    AnyCard
+};
+
+// Compile-time Klondike rule set. The engine functions, move generator and
+// solver take one as a template parameter, so every rule is a constant in
+// their loops and each variant gets its own instantiation.
+template <int Draw, int Passes = 0, bool FoundationToTableau = true,
+          EmptyColumnRule EmptyColumn = EmptyColumnRule::KingsOnly>
+struct KlondikeRules {
+    static_assert(Draw >= 1 && Draw <= STOCK_CARDS, "draw count out of range");
+    static_assert(Passes >= 0, "passes out of range");
+
+    static constexpr int drawCount = Draw;
+    static constexpr int maxPasses = Passes; // times through the stock, 0 = unlimited
+    static constexpr bool foundationToTableau = FoundationToTableau;
+    static constexpr EmptyColumnRule emptyColumn = EmptyColumn;
+
+    // Only limited rules count recycles, so unlimited ones keep
+    // Position::recycles at 0 and hash equal positions equally
+    static constexpr bool countsRecycles = Passes > 0;
+
+    static constexpr bool canRecycle(const int recycles) {
+        return !countsRecycles || recycles + 1 < maxPasses;
+    }
+
+    static constexpr bool anyCardStartsColumn = EmptyColumn == EmptyColumnRule::AnyCard;
+
+    static constexpr bool canStartColumn(const CardId card) {
+        return anyCardStartsColumn || rankValue(card) == 13;
+    }
+
+    // Bound on generateMoves output; any-card columns add up to one move per
+    // face-up card, so their buffers are sized for it and the common rules
+    // keep the smaller search frames
+    static constexpr int maxMoves = anyCardStartsColumn ? MAX_MOVES + DECK_SIZE : MAX_MOVES;
+};
+
+using Draw1Rules = KlondikeRules<1>;
+using Draw3Rules = KlondikeRules<3>;
+using Draw3ThreePassRules = KlondikeRules<3, 3>;
+
+// Rule sets that can be chosen at run time (UI difficulty, command lines,
+// save files). Adding a variant is a using line above plus a case here.
+enum class RuleVariant : uint8_t {
+    Draw1,
+    Draw3,
+    Draw3ThreePasses
+};
+
+// Calls f with the rule set for variant as a value of that type, so one
+// branch here picks the instantiation and none happen inside f
+template <typename F>
+decltype(auto) withRules(const RuleVariant variant, F&& f) {
+    switch (variant) {
+        case RuleVariant::Draw3:            return f(Draw3Rules{});
+        case RuleVariant::Draw3ThreePasses: return f(Draw3ThreePassRules{});
+        default:                            return f(Draw1Rules{});
+    }
+}
+
+// Names used on command lines and in network protocols
+inline const char* rulesName(const RuleVariant rules) {
+    switch (rules) {
+        case RuleVariant::Draw1:            return "draw1";
+        case RuleVariant::Draw3:            return "draw3";
+        case RuleVariant::Draw3ThreePasses: return "draw3x3";
+    }
+    return "?";
+}
+
+inline bool parseRules(const std::string_view name, RuleVariant& rules) {
+    for (const RuleVariant variant : {RuleVariant::Draw1, RuleVariant::Draw3, RuleVariant::Draw3ThreePasses}) {
+        if (name == rulesName(variant)) {
+            rules = variant;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Plain draw-N variant for command-line tools
+inline RuleVariant drawVariant(const int drawCount) {
+    return drawCount == 3 ? RuleVariant::Draw3 : RuleVariant::Draw1;
+}
+
+#endif // RULES_H
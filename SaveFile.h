@@ -0,0 +1,116 @@
+#ifndef SAVEFILE_H
+#define SAVEFILE_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Position.h"
+
+// Fixed part of a saved game, followed in the file by timelineSize moves.
+// Plain data in native byte order; anything that does not match the magic,
+// version or size is treated as no save at all.
+struct SaveHeader {
+    static constexpr uint32_t MAGIC = 0x534C4F53; // "SOLS"
+    static constexpr uint16_t VERSION = 4; // 2: Position::recycles, 3: Position card masks, 4: Position::faceDownCards
+
+    uint32_t magic = MAGIC;
+    uint16_t version = VERSION;
+    uint8_t difficulty = 0;
+    uint8_t undoDepth = 0;       // moves at the cursor that can still be undone
+    uint64_t seed = 0;
+    uint32_t moves = 0;
+    uint32_t timelineCursor = 0;
+    uint32_t timelineSize = 0;   // moves past the cursor are a rewound tail
+    std::array<char, 32> playerName{};
+    Position position;           // table at the cursor, to check the replay against
+};
+
+static_assert(std::is_trivially_copyable_v<SaveHeader>);
+static_assert(std::is_trivially_copyable_v<EngineMove>);
+
+struct SaveData {
+    SaveHeader header;
+    std::vector<EngineMove> moves;
+
+    std::string playerName() const {
+        return {header.playerName.data(), strnlen(header.playerName.data(), header.playerName.size())};
+    }
+};
+
+// Game saved after every move. A save is written whole to a temporary file
+// next to the save and renamed over it, so a crash or a full disk part way
+// through leaves the previous save as it was. A load is one read.
+class SaveFile {
+public:
+    explicit SaveFile(std::string path) : path(std::move(path)), tempPath(this->path + ".tmp") {}
+
+    SaveFile(const SaveFile&) = delete;
+    SaveFile& operator=(const SaveFile&) = delete;
+
+    bool read(SaveData& data) const {
+        std::FILE* in = std::fopen(path.c_str(), "rb");
+        if (!in) return false;
+
+        std::vector<char> bytes;
+        if (std::fseek(in, 0, SEEK_END) == 0) {
+            const long size = std::ftell(in);
+            if (size > 0) {
+                bytes.resize(static_cast<size_t>(size));
+                std::rewind(in);
+                if (std::fread(bytes.data(), 1, bytes.size(), in) != bytes.size()) bytes.clear();
+            }
+        }
+        std::fclose(in);
+
+        if (bytes.size() < sizeof(SaveHeader)) return false;
+        std::memcpy(&data.header, bytes.data(), sizeof(SaveHeader));
+
+        const SaveHeader& header = data.header;
+        if (header.magic != SaveHeader::MAGIC || header.version != SaveHeader::VERSION) return false;
+        if (header.timelineCursor > header.timelineSize) return false;
+
+        // Each save replaces the whole file, so the moves fill the rest of it
+        const size_t movesBytes = static_cast<size_t>(header.timelineSize) * sizeof(EngineMove);
+        if (bytes.size() - sizeof(SaveHeader) != movesBytes) return false;
+
+        data.moves.resize(header.timelineSize);
+        std::memcpy(data.moves.data(), bytes.data() + sizeof(SaveHeader), movesBytes);
+        return true;
+    }
+
+    bool write(const SaveHeader& header, const EngineMove* moves) {
+        std::FILE* out = std::fopen(tempPath.c_str(), "wb");
+        if (!out) return false;
+
+        bool written = std::fwrite(&header, sizeof(SaveHeader), 1, out) == 1 &&
+                       std::fwrite(moves, sizeof(EngineMove), header.timelineSize, out) == header.timelineSize;
+        written = std::fclose(out) == 0 && written;
+
+        // Replaces an existing save on Windows too, unlike std::rename
+        std::error_code error;
+        if (written) std::filesystem::rename(tempPath, path, error);
+        if (!written || error) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Drops the save, e.g. once the game is won
+    void remove() {
+        std::remove(path.c_str());
+    }
+
+private:
+    std::string path;
+    std::string tempPath; // each save is written here first
+};
+
+#endif // SAVEFILE_H
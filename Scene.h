@@ -0,0 +1,95 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <vector>
+
+#include "Renderable.h"
+#include "ScreenBuffer.h"
+
+// Retained set of Renderables drawn onto one ScreenBuffer.
+//
+// Nothing is drawn from scratch each frame: a node is drawn again only if it
+// is dirty. Its old area is painted with the background first, so a pile
+// that moved or shrank leaves nothing behind, and clean nodes overlapping a
+// repainted area are redrawn with it. invalidate() forces a full redraw,
+// e.g. after the buffer was resized or cleared.
+class Scene {
+public:
+    // The node must outlive the scene and have render(ScreenBuffer&) and bounds()
+    template <typename Node>
+    void add(Node& node) {
+        nodes.push_back({
+            &node,
+            [](Renderable& n, ScreenBuffer& screen) { static_cast<Node&>(n).render(screen); },
+            [](const Renderable& n) { return static_cast<const Node&>(n).bounds(); }
+        });
+    }
+
+    void invalidate() {
+        full = true;
+    }
+
+    // Draws what changed since the last call, returns how many nodes were drawn
+    int render(ScreenBuffer& screen, const WORD background) {
+        if (full) {
+            Renderable::fill(screen, {0, 0, screen.width, screen.height}, background);
+            for (const Node& node : nodes) {
+                node.renderable->markDirty();
+            }
+            full = false;
+        }
+
+        // Areas repainted this frame: old and new bounds of each dirty node
+        repainted.clear();
+        for (const Node& node : nodes) {
+            if (!node.renderable->isDirty()) continue;
+            repainted.push_back(node.renderable->drawnArea());
+            repainted.push_back(node.bounds(*node.renderable));
+        }
+
+        // A clean node under a repainted area has to be drawn again, which
+        // can repaint more; there are few nodes, so just loop until stable
+        for (bool grown = true; grown;) {
+            grown = false;
+            for (const Node& node : nodes) {
+                if (node.renderable->isDirty()) continue;
+                const Rect& area = node.renderable->drawnArea();
+                for (const Rect& other : repainted) {
+                    if (!area.intersects(other)) continue;
+                    node.renderable->markDirty();
+                    repainted.push_back(area);
+                    repainted.push_back(node.bounds(*node.renderable));
+                    grown = true;
+                    break;
+                }
+            }
+        }
+
+        // Clear everything first, so no node paints over one drawn before it
+        for (const Node& node : nodes) {
+            if (node.renderable->isDirty()) Renderable::fill(screen, node.renderable->drawnArea(), background);
+        }
+
+        int drawn = 0;
+        for (const Node& node : nodes) {
+            if (!node.renderable->isDirty()) continue;
+            node.render(*node.renderable, screen);
+            node.renderable->markDrawn(node.bounds(*node.renderable));
+            drawn++;
+        }
+        return drawn;
+    }
+
+private:
+    struct Node {
+        Renderable* renderable;
+        void (*render)(Renderable&, ScreenBuffer&);
+        Rect (*bounds)(const Renderable&);
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Rect> repainted;
+    bool full = true;
+};
+
+#endif // SCENE_H
@@ -0,0 +1,168 @@
+#ifndef SCOREVERIFIER_H
+#define SCOREVERIFIER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Position.h"
+#include "Rules.h"
+
+// A finished game as reported by a client: the deal, the rules and every
+// move, so the claimed move count can be checked rather than trusted.
+struct ScoreSubmission {
+    std::string name;
+    uint64_t seed = 0;
+    RuleVariant rules = RuleVariant::Draw1;
+    int moves = 0; // claimed
+    std::vector<EngineMove> log;
+};
+
+enum class ReplayVerdict {
+    Accepted,
+    CountMismatch, // claimed moves differ from the log length
+    IllegalMove,
+    NotWon
+};
+
+struct VerifiedScore {
+    ScoreSubmission submission;
+    ReplayVerdict verdict = ReplayVerdict::NotWon;
+    size_t failedMove = 0; // index of the illegal move, if any
+
+    bool accepted() const {
+        return verdict == ReplayVerdict::Accepted;
+    }
+};
+
+// Replays the log from the deal; the score stands only if every move is
+// legal and the last one wins the game
+inline VerifiedScore verifyScore(ScoreSubmission submission) {
+    VerifiedScore result;
+    if (submission.moves < 0 || static_cast<size_t>(submission.moves) != submission.log.size()) {
+        result.verdict = ReplayVerdict::CountMismatch;
+    } else {
+        result.verdict = withRules(submission.rules, [&](auto rules) {
+            using Rules = decltype(rules);
+            Position pos = dealPosition(submission.seed);
+            for (size_t i = 0; i < submission.log.size(); i++) {
+                if (!isLegalMove<Rules>(pos, submission.log[i])) {
+                    result.failedMove = i;
+                    return ReplayVerdict::IllegalMove;
+                }
+                applyMove<Rules>(pos, submission.log[i]);
+            }
+            return pos.isWin() ? ReplayVerdict::Accepted : ReplayVerdict::NotWon;
+        });
+    }
+    result.submission = std::move(submission);
+    return result;
+}
+
+// Checks submissions on worker threads. The queue is bounded: trySubmit
+// never blocks the caller and reports a full queue instead, submit waits
+// for room. Verdicts are picked up with collect, typically once per frame
+// on the thread that owns the ScoreManager.
+class ScoreVerifier {
+public:
+    explicit ScoreVerifier(const int threads = 1, const size_t capacity = 1024)
+        : capacity(std::max<size_t>(1, capacity)) {
+        for (int i = 0; i < std::max(1, threads); i++) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    // Finishes the submissions already queued, then stops
+    ~ScoreVerifier() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        jobReady.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ScoreVerifier(const ScoreVerifier&) = delete;
+    ScoreVerifier& operator=(const ScoreVerifier&) = delete;
+
+    bool trySubmit(ScoreSubmission&& submission) {
+        {
+            std::lock_guard lock(mutex);
+            if (queue.size() >= capacity) return false;
+            queue.push_back(std::move(submission));
+        }
+        jobReady.notify_one();
+        return true;
+    }
+
+    void submit(ScoreSubmission&& submission) {
+        {
+            std::unique_lock lock(mutex);
+            slotFree.wait(lock, [this] { return queue.size() < capacity; });
+            queue.push_back(std::move(submission));
+        }
+        jobReady.notify_one();
+    }
+
+    // Moves every verdict reached so far into out, returns how many
+    size_t collect(std::vector<VerifiedScore>& out) {
+        std::lock_guard lock(mutex);
+        const size_t count = results.size();
+        std::move(results.begin(), results.end(), std::back_inserter(out));
+        results.clear();
+        return count;
+    }
+
+    // Blocks until every submission so far has a verdict
+    void waitIdle() {
+        std::unique_lock lock(mutex);
+        idle.wait(lock, [this] { return queue.empty() && busy == 0; });
+    }
+
+private:
+    size_t capacity;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable slotFree;
+    std::condition_variable idle;
+    std::deque<ScoreSubmission> queue;
+    std::vector<VerifiedScore> results;
+    int busy = 0;
+    bool stopping = false;
+
+    void work() {
+        while (true) {
+            std::unique_lock lock(mutex);
+            jobReady.wait(lock, [this] { return !queue.empty() || stopping; });
+            if (queue.empty()) return;
+
+            ScoreSubmission submission = std::move(queue.front());
+            queue.pop_front();
+            busy++;
+            lock.unlock();
+            slotFree.notify_one();
+
+            VerifiedScore verdict = verifyScore(std::move(submission));
+
+            lock.lock();
+            results.push_back(std::move(verdict));
+            busy--;
+            const bool nowIdle = queue.empty() && busy == 0;
+            lock.unlock();
+            if (nowIdle) idle.notify_all();
+        }
+    }
+};
+
+#endif // SCOREVERIFIER_H
@@ -0,0 +1,36 @@
+#ifndef SCREENBACKEND_H
+#define SCREENBACKEND_H
+
+#include <vector>
+
+#include "ConsoleApi.h"
+#include "Input.h"
+
+// Snapshot of a buffer handed to the render thread
+struct ConsoleFrame {
+    short width = 0;
+    short height = 0;
+    std::vector<CHAR_INFO> cells;
+    InputClock::time_point input{}; // oldest key first shown by this frame, if any
+};
+
+// Where the frames of a ScreenBuffer go: a console screen buffer, a
+// terminal, or memory when there is no screen at all
+class ScreenBackend {
+public:
+    virtual ~ScreenBackend() = default;
+
+    // Visible area in cells when the buffer is created
+    virtual void initialSize(short& width, short& height) = 0;
+
+    // True with the visible area if it may have changed since the last call
+    virtual bool resized(short& width, short& height) = 0;
+
+    // Brings this screen to the front
+    virtual void activate() = 0;
+
+    // Shows a frame; runs on the render thread
+    virtual void present(const ConsoleFrame& frame) = 0;
+};
+
+#endif // SCREENBACKEND_H
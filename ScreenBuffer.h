@@ -5,11 +5,14 @@
 #ifndef SCREENBUFFER_H
 #define SCREENBUFFER_H
 
-#include <Windows.h>
+#include <atomic>
+#include <memory>
+#include <utility>
 #include <vector>
-#include <conio.h>
 
 #include "Logger.h"
+#include "RenderThread.h"
+#include "ScreenBackend.h"
 
 class ScreenBuffer {
 public:
@@ -17,62 +20,27 @@ public:
     short height;
     std::vector<CHAR_INFO> buffer;
 
-    ScreenBuffer() {
-        hConsoleBuffer = CreateConsoleScreenBuffer(
-            GENERIC_READ | GENERIC_WRITE,
-            0,
-            nullptr,
-            CONSOLE_TEXTMODE_BUFFER,
-            nullptr
-        );
-
-        if (hConsoleBuffer == INVALID_HANDLE_VALUE) {
-            Logger::error("Failed to create screen buffer");
-            exit(1);
-        }
-
-        CONSOLE_SCREEN_BUFFER_INFO csbi;
-        if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi)) {
-            Logger::error("Failed to get screen info");
-            exit(1);
-        }
-
-        width = static_cast<short>(csbi.srWindow.Right - csbi.srWindow.Left + 1);
-        height = static_cast<short>(csbi.srWindow.Bottom - csbi.srWindow.Top + 1);
-
+    explicit ScreenBuffer(std::unique_ptr<ScreenBackend> screenBackend)
+        : backend(std::move(screenBackend)),
+          presenter([this](const ConsoleFrame& frame) { present(frame); }) {
+        backend->initialSize(width, height);
         resizeBuffer(width, height);
     }
 
-    static bool getInputChar(wchar_t &ch) {
-        if (_kbhit()) {
-            ch = _getwch();
-            return true;
-        }
-        return false;
-    }
-
     void activate() const {
-        if (!SetConsoleActiveScreenBuffer(hConsoleBuffer)) {
-            Logger::error("Failed to activate screen buffer");
-        }
+        backend->activate();
     }
 
     bool updateSizeIfChanged() {
-        CONSOLE_SCREEN_BUFFER_INFO csbi;
-        if (GetConsoleScreenBufferInfo(this->hConsoleBuffer, &csbi)) {
-            const short newWidth = csbi.srWindow.Right - csbi.srWindow.Left + 1;
-            const short newHeight = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
-
-            if (newWidth != width || newHeight != height) {
-                Logger::info("Screen resized: ", newWidth, "x", newHeight);
-                width = newWidth;
-                height = newHeight;
-                resizeBuffer(newWidth, newHeight);
-
-                return true;
-            }
-        } else {
-            Logger::error("GetConsoleScreenBufferInfo failed");
+        short newWidth = width;
+        short newHeight = height;
+        if (!backend->resized(newWidth, newHeight)) return false;
+
+        if (newWidth != width || newHeight != height) {
+            Logger::info("Screen resized: ", newWidth, "x", newHeight);
+            resizeBuffer(newWidth, newHeight);
+
+            return true;
         }
 
         return false;
@@ -85,22 +53,44 @@ public:
         }
     }
 
-    void render() const {
-        SMALL_RECT rect = {0, 0, static_cast<SHORT>(width - 1), static_cast<SHORT>(height - 1)};
-        const COORD bufferSize = {width, height};
-        constexpr COORD bufferCoord = {0, 0};
-
-        WriteConsoleOutputW(
-            hConsoleBuffer,
-            buffer.data(),
-            bufferSize,
-            bufferCoord,
-            &rect
-        );
+    // Hands a copy of the buffer to the render thread and returns at once;
+    // the backend writes it there, and a frame still waiting when the next
+    // one arrives is dropped. input is the arrival time of the oldest key
+    // this frame answers, if any.
+    void render(const InputClock::time_point input = {}) {
+        ConsoleFrame& frame = presenter.frame();
+        frame.width = width;
+        frame.height = height;
+        frame.cells.assign(buffer.begin(), buffer.end());
+        frame.input = input;
+        presenter.submit();
+    }
+
+    // Waits until the last render() is on screen
+    void flush() {
+        presenter.flush();
+    }
+
+    // From a key arriving to the screen showing its effect, for the last
+    // frame rendered with an input time
+    std::chrono::microseconds lastInputLatency() const {
+        return std::chrono::microseconds(inputLatency.load(std::memory_order_relaxed));
     }
 
 private:
-    HANDLE hConsoleBuffer;
+    std::unique_ptr<ScreenBackend> backend;
+    std::atomic<int64_t> inputLatency{0}; // microseconds
+    RenderThread<ConsoleFrame> presenter; // last member: its thread stops before the rest goes
+
+    // Runs on the render thread
+    void present(const ConsoleFrame& frame) {
+        backend->present(frame);
+
+        if (frame.input != InputClock::time_point{}) {
+            const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(InputClock::now() - frame.input);
+            inputLatency.store(latency.count(), std::memory_order_relaxed);
+        }
+    }
 
     void resizeBuffer(const short newWidth, const short newHeight) {
         width = newWidth;
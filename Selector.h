@@ -34,15 +34,19 @@ public:
 
         selectedIndex = 0;
         setSize(calculateWidth(options, label), 1);
+        markDirty();
     }
 
     void setActive(const bool isActive) {
+        if (isActive == active) return;
         active = isActive;
+        markDirty();
     }
 
     void setSelectedIndex(const int index) {
         if (index >= 0 && index < static_cast<int>(options.size())) {
             selectedIndex = index;
+            markDirty();
         }
     }
 
@@ -134,6 +138,7 @@ private:
         } else {
             selectedIndex = static_cast<int>(options.size()) - 1;
         }
+        markDirty();
     }
 
     void moveRight() {
@@ -142,6 +147,7 @@ private:
         } else {
             selectedIndex = 0;
         }
+        markDirty();
     }
 };
 
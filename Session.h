@@ -0,0 +1,214 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "MoveNotation.h"
+#include "Position.h"
+#include "Rules.h"
+
+// One headless game for the session server: the engine position, the rule
+// set and a short undo history, with no ScreenBuffer or console behind it.
+// Everything lives inline, so an idle session is sizeof(Session) bytes.
+//
+// Text protocol, one request and one reply per line:
+//   new <seed> [draw1|draw3|draw3x3]  -> state <piles>
+//   state                             -> state <piles>
+//   <move>  (MoveNotation.h)          -> ok <changed piles> [win]
+//   undo                              -> ok <changed piles>
+//   moves                             -> moves <move>...
+//   anything unusable                 -> err <reason>
+//
+// Piles are written as S<n> (cards left in the stock), W:<waste top>,
+// F<i>:<top> and T<i>:<face-down count>:<face-up cards, comma separated>,
+// so face-down cards never leave the server. "ok" carries only the piles
+// the request changed, the frame diff a client applies to its copy.
+class Session {
+public:
+    static constexpr int UNDO_DEPTH = 3; // as in SolitaireGame
+
+    // Appends the reply to the request and a newline to out
+    void handle(const std::string_view request, std::string& out) {
+        if (request.starts_with("new")) {
+            startGame(request.substr(3), out);
+        } else if (!started) {
+            out += "err no game, send: new <seed> [rules]";
+        } else if (request == "state") {
+            appendState(out);
+        } else if (request == "undo") {
+            undo(out);
+        } else if (request == "moves") {
+            appendMoves(out);
+        } else {
+            play(request, out);
+        }
+        out += '\n';
+    }
+
+    const Position& position() const {
+        return pos;
+    }
+
+    uint32_t moveCount() const {
+        return moves;
+    }
+
+private:
+    // 13 piles: stock, waste, foundations 0-3, tableau 0-6
+    static constexpr int PILES = 2 + FOUNDATION_PILES + TABLEAU_COLUMNS;
+
+    Position pos;
+    std::array<MoveRecord, UNDO_DEPTH> history{};
+    uint32_t moves = 0;
+    uint8_t historySize = 0;
+    uint8_t historyNext = 0; // ring index of the next record
+    RuleVariant rules = RuleVariant::Draw1;
+    bool started = false;
+
+    void startGame(std::string_view args, std::string& out) {
+        while (args.starts_with(' ')) args.remove_prefix(1);
+        const size_t space = args.find(' ');
+        const std::string_view seedText = args.substr(0, space);
+        const std::string_view rulesText = space == std::string_view::npos ? "" : args.substr(space + 1);
+
+        uint64_t seed = 0;
+        const auto [end, error] = std::from_chars(seedText.data(), seedText.data() + seedText.size(), seed);
+        if (error != std::errc{} || end != seedText.data() + seedText.size() || seedText.empty()) {
+            out += "err expected: new <seed> [rules]";
+            return;
+        }
+
+        RuleVariant variant = RuleVariant::Draw1;
+        if (!rulesText.empty() && !parseRules(rulesText, variant)) {
+            out += "err unknown rules";
+            return;
+        }
+
+        pos = dealPosition(seed);
+        rules = variant;
+        moves = 0;
+        historySize = historyNext = 0;
+        started = true;
+        appendState(out);
+    }
+
+    void play(const std::string_view request, std::string& out) {
+        EngineMove move;
+        if (!parseMove(request, move)) {
+            out += "err unknown request";
+            return;
+        }
+
+        const Position before = pos;
+        const bool legal = withRules(rules, [&](auto r) {
+            using Rules = decltype(r);
+            if (!isLegalMove<Rules>(pos, move)) return false;
+            history[historyNext] = applyMove<Rules>(pos, move);
+            return true;
+        });
+        if (!legal) {
+            out += "err illegal move";
+            return;
+        }
+
+        historyNext = static_cast<uint8_t>((historyNext + 1) % UNDO_DEPTH);
+        if (historySize < UNDO_DEPTH) historySize++;
+        moves++;
+
+        out += "ok";
+        appendChanges(before, out);
+        if (pos.isWin()) out += " win";
+    }
+
+    void undo(std::string& out) {
+        if (historySize == 0) {
+            out += "err nothing to undo";
+            return;
+        }
+
+        historyNext = static_cast<uint8_t>((historyNext + UNDO_DEPTH - 1) % UNDO_DEPTH);
+        historySize--;
+        moves--;
+
+        const Position before = pos;
+        withRules(rules, [&](auto r) { undoMove<decltype(r)>(pos, history[historyNext]); });
+
+        out += "ok";
+        appendChanges(before, out);
+    }
+
+    void appendMoves(std::string& out) const {
+        out += "moves";
+        withRules(rules, [&](auto r) {
+            using Rules = decltype(r);
+            std::array<EngineMove, Rules::maxMoves> legal;
+            const int count = generateMoves<Rules>(pos, legal.data());
+            for (int i = 0; i < count; i++) {
+                out += ' ';
+                out += moveToString(legal[i]);
+            }
+        });
+    }
+
+    void appendState(std::string& out) const {
+        out += "state";
+        for (int pile = 0; pile < PILES; pile++) {
+            out += ' ';
+            appendPile(pos, pile, out);
+        }
+        out += " moves:";
+        out += std::to_string(moves);
+    }
+
+    void appendChanges(const Position& before, std::string& out) const {
+        for (int pile = 0; pile < PILES; pile++) {
+            if (!samePile(before, pos, pile)) {
+                out += ' ';
+                appendPile(pos, pile, out);
+            }
+        }
+    }
+
+    static bool samePile(const Position& a, const Position& b, const int pile) {
+        if (pile == 0) return a.stockSize - a.cursor == b.stockSize - b.cursor;
+        if (pile == 1) return a.wasteTop() == b.wasteTop();
+        if (pile < 2 + FOUNDATION_PILES) return a.foundation[pile - 2] == b.foundation[pile - 2];
+
+        const int column = pile - 2 - FOUNDATION_PILES;
+        return a.columnSize[column] == b.columnSize[column] && a.faceDown[column] == b.faceDown[column] &&
+               std::memcmp(a.tableau[column].data(), b.tableau[column].data(), a.columnSize[column]) == 0;
+    }
+
+    static void appendPile(const Position& p, const int pile, std::string& out) {
+        if (pile == 0) {
+            out += 'S';
+            out += std::to_string(p.stockSize - p.cursor);
+        } else if (pile == 1) {
+            out += "W:";
+            out += cardToString(p.wasteTop());
+        } else if (pile < 2 + FOUNDATION_PILES) {
+            out += 'F';
+            out += static_cast<char>('0' + pile - 2);
+            out += ':';
+            out += cardToString(p.foundation[pile - 2]);
+        } else {
+            const int column = pile - 2 - FOUNDATION_PILES;
+            out += 'T';
+            out += static_cast<char>('0' + column);
+            out += ':';
+            out += std::to_string(p.faceDown[column]);
+            out += ':';
+            for (int i = p.faceDown[column]; i < p.columnSize[column]; i++) {
+                if (i > p.faceDown[column]) out += ',';
+                out += cardToString(p.tableau[column][i]);
+            }
+        }
+    }
+};
+
+#endif // SESSION_H
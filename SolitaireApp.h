@@ -0,0 +1,349 @@
+#ifndef SOLITAIREAPP_H
+#define SOLITAIREAPP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DeadDeal.h"
+#include "InputBox.h"
+#include "Selector.h"
+#include "SolitaireGame.h"
+#include "ScoreManager.h"
+
+struct AppConfig {
+    std::string scoresPath = "scores.txt";  // Save/load from file
+    std::string savePath = "savegame.bin";  // Game in progress, written after every move
+    uint64_t dealSeed = 0;                  // Seeds the deals of a scripted run; 0 deals at random
+};
+
+// The whole application: the menu, the game and the win screen, each on a
+// ScreenBuffer of its own. step() is one pass of the main loop with the
+// keys that arrived since the last one. main feeds it from an InputThread
+// and the console; the headless tools feed it scripted keys and keep the
+// screens in memory.
+class SolitaireApp {
+public:
+    using BackendFactory = std::function<std::unique_ptr<ScreenBackend>()>;
+
+    enum class Screen { Menu, Game, Won };
+
+    SolitaireApp(const AppConfig& config, const BackendFactory& makeBackend)
+        : scoreManager(config.scoresPath),
+          saveFile(config.savePath),
+          canResume(saveFile.read(savedGame)),
+          deals(config.dealSeed != 0 ? config.dealSeed : (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}()),
+          gameBuffer(makeBackend()),
+          game(gameBuffer.width, gameBuffer.height),
+          menuBuffer(makeBackend()),
+          menu(menuBuffer.width, menuBuffer.height),
+          resumeSelector({L"Tak", L"Nie"}, L"Wznowić zapisaną grę?"),
+          difficultySelector({L"Łatwy", L"Ciężki", L"Ekspert"}, L"Poziom trudności"),
+          input(20, L"Wprowadź swoje imie", L"np. monika"),
+          winBuffer(makeBackend()),
+          winScreen(winBuffer.width, winBuffer.height) {
+        buildMenu();
+
+        winBuffer.clear();
+        winScreen.clear(winBuffer, BG_GREEN);
+    }
+
+    // Keeps pointers into itself
+    SolitaireApp(const SolitaireApp&) = delete;
+    SolitaireApp& operator=(const SolitaireApp&) = delete;
+
+    void step(const std::vector<KeyEvent>& arrived) {
+        // Keys left over when the screen changed mid-batch go first
+        keys.erase(keys.begin(), keys.begin() + static_cast<std::ptrdiff_t>(nextKey));
+        nextKey = 0;
+        keys.insert(keys.end(), arrived.begin(), arrived.end());
+
+        verifiedScores.clear();
+        scoreVerifier.collect(verifiedScores);
+        for (const VerifiedScore& score : verifiedScores) {
+            if (!score.accepted()) continue;
+            scoreManager.addScore(score.submission.name, score.submission.moves);
+            winChanged = true;
+        }
+
+        if (renderGame) {
+            stepGame();
+        } else if (preGameWon) {
+            stepWon();
+        } else {
+            stepMenu();
+        }
+    }
+
+    Screen screen() const {
+        return renderGame ? Screen::Game : preGameWon ? Screen::Won : Screen::Menu;
+    }
+
+    const SolitaireGame& getGame() const {
+        return game;
+    }
+
+    // Blocks until the scores of won games are recorded or rejected
+    void waitForScores() {
+        scoreVerifier.waitIdle();
+    }
+
+    // Blocks until every screen shows its last rendered frame
+    void flush() {
+        gameBuffer.flush();
+        menuBuffer.flush();
+        winBuffer.flush();
+    }
+
+private:
+    std::wstring playerName;
+    ScoreManager scoreManager;
+    ScoreVerifier scoreVerifier;             // Replays each win before it is recorded
+    std::vector<VerifiedScore> verifiedScores;
+    SaveFile saveFile;
+    SaveData savedGame;
+    const bool canResume;
+
+    bool renderGame = false;
+    bool preGameWon = false;
+    Difficulty selectedDifficulty = Difficulty::Easy; // Store selected difficulty
+    std::mt19937_64 deals;
+
+    std::vector<KeyEvent> keys; // Handed out in order, a batch per step
+    size_t nextKey = 0;
+
+    ScreenBuffer gameBuffer;
+    SolitaireGame game;
+
+    // --[MENU]---------------------------------------------------------------------------------------------------------
+    ScreenBuffer menuBuffer;
+    Renderable menu;
+    Selector resumeSelector;
+    Selector difficultySelector;
+    InputBox input;
+    enum ActiveElement { RESUME, DIFFICULTY, NAME_INPUT } activeElement = DIFFICULTY;
+
+    // --[WIN ]---------------------------------------------------------------------------------------------------------
+    ScreenBuffer winBuffer;
+    Renderable winScreen;
+    bool winChanged = false; // scores or size changed since the win screen was drawn
+
+    bool takeKey(KeyEvent& event) {
+        if (nextKey == keys.size()) return false;
+        event = keys[nextKey++];
+        return true;
+    }
+
+    // Arrival time of the oldest key not handled yet
+    InputClock::time_point oldestKey() const {
+        return nextKey < keys.size() ? keys[nextKey].time : InputClock::time_point{};
+    }
+
+    void buildMenu() {
+        menuBuffer.clear();
+        menuBuffer.activate();
+        menu.clear(menuBuffer, BG_GREEN);
+
+        std::wstring text[] = {
+            L"Instrukcja obsługi:                                                       ",
+            L"- Wybierz stos spośród [QWERTY] i [1234567]                               ",
+            L"- Jeżeli na stosie znajduje się wiele odkrytych kart,                     ",
+            L"  wybierz jedną strzałkami [<-] / [->] a następnie zatwierdź [ENTER]      ",
+            L"- Aby anulować ruch kliknij [Q]                                           ",
+            L"- Okienko menu można zmieniać rozmiar - przeciągnij jego krawędzie myszką.",
+            L"- Zmiana rozmiaru pozwala lepiej dopasować widok do Twoich potrzeb.       ",
+            L"Ciesz się grą i powodzenia!                                               "
+        };
+
+        size_t linesCount = std::size(text);
+        size_t maxLineLength = 0;
+        for (size_t i = 0; i < linesCount; i++) {
+            if (text[i].size() > maxLineLength) maxLineLength = text[i].size();
+        }
+
+        int startX = (menuBuffer.width - static_cast<int>(maxLineLength)) / 2;
+        int startY = (menuBuffer.height / 2) - static_cast<int>(linesCount);
+
+        for (size_t i = 0; i < linesCount; i++) {
+            menu.drawText(menuBuffer, startX, startY + static_cast<int>(i), text[i].c_str(), FG_WHITE | 0);
+        }
+
+        // The resume question goes first and pushes the other fields down
+        const int resumeOffset = canResume ? 2 : 0;
+        resumeSelector.setPos(menuBuffer.width / 2 - resumeSelector.width / 2, startY + static_cast<int>(linesCount) + 2);
+        resumeSelector.setActive(canResume);
+
+        difficultySelector.setPos(menuBuffer.width / 2 - difficultySelector.width / 2, startY + static_cast<int>(linesCount) + 2 + resumeOffset);
+        difficultySelector.setActive(!canResume);
+
+        input.setPos(menuBuffer.width / 2 - input.width / 2, startY + static_cast<int>(linesCount) + 4 + resumeOffset);
+        input.setActive(false);
+
+        activeElement = canResume ? RESUME : DIFFICULTY;
+
+        resumeSelector.onSelect = [this](const int index, const std::wstring&) {
+            resumeSelector.setActive(false);
+
+            if (index == 0 && game.resume(savedGame)) {
+                const std::string name = savedGame.playerName();
+                playerName = std::wstring(name.begin(), name.end());
+                renderGame = true;
+                gameBuffer.activate();
+                return;
+            }
+
+            difficultySelector.setActive(true);
+            activeElement = DIFFICULTY;
+        };
+
+        difficultySelector.onSelect = [this](int index, const std::wstring&) {
+            selectedDifficulty = static_cast<Difficulty>(index);
+
+            difficultySelector.setActive(false);
+            input.setActive(true);
+            game.setDifficulty(selectedDifficulty);
+            activeElement = NAME_INPUT;
+        };
+
+        input.onEnter = [this](const std::wstring& text) {
+            playerName = text;
+            input.setActive(false);
+            renderGame = true;
+            gameBuffer.activate();
+            game.setup(nextDeal());
+        };
+    }
+
+    // Seed of the next game, passing over deals that are certainly lost
+    uint64_t nextDeal() {
+        return game.withGameRules([this](auto rules) {
+            uint64_t seed = deals();
+            while (findDeadDeal<decltype(rules)>(dealPosition(seed)) != DeadDeal::None) seed = deals();
+            return seed;
+        });
+    }
+
+    void stepGame() {
+        if (gameBuffer.updateSizeIfChanged()) {
+            game.updateSize(gameBuffer);
+            gameBuffer.clear();
+        }
+
+        if (game.restartRequested) {
+            game.setup(nextDeal()); // This will reset the game and clear the restart flag
+            gameBuffer.clear();
+        }
+
+        if (game.isWin()) {
+            renderGame = false;
+            preGameWon = true;
+            winChanged = true;
+            winBuffer.activate();
+            std::string name(playerName.begin(), playerName.end());
+            scoreVerifier.trySubmit(game.scoreSubmission(name));
+            saveFile.remove();
+            return;
+        }
+
+        // The whole batch, unless a key ends or restarts the game
+        const InputClock::time_point firstKey = oldestKey();
+        for (KeyEvent event{}; !game.restartRequested && !game.isWin() && takeKey(event);) {
+            game.handleInput(event);
+        }
+
+        if (game.takeChanges()) {
+            game.save(saveFile, std::string(playerName.begin(), playerName.end()));
+        }
+
+        if (game.render(gameBuffer)) gameBuffer.render(firstKey);
+    }
+
+    void stepWon() {
+        nextKey = keys.size(); // nothing to type into
+
+        if (gameBuffer.updateSizeIfChanged()) {
+            winScreen.setSize(winBuffer.width, winBuffer.height);
+            winBuffer.clear();
+            winChanged = true;
+        }
+
+        // Drawn again only when the scores or the size change
+        if (!winChanged) return;
+        winChanged = false;
+
+        winScreen.clear(winBuffer, BG_GREEN);
+
+        const auto& scores = scoreManager.getAllScores();
+        constexpr int maxDisplay = 10;
+        int count = std::min((int)scores.size(), maxDisplay);
+        const int startY = winBuffer.height / 2 - count / 2;
+
+        // Calculate the maximum line width for centering
+        int maxLineWidth = 0;
+        std::vector<std::wstring> lines;
+
+        for (int i = 0; i < count; ++i) {
+            const auto&[name, moves] = scores[i];
+            std::wstring line = std::to_wstring(i + 1) + L". " +
+                std::wstring(name.begin(), name.end()) + L": " +
+                std::to_wstring(moves) + L" ruchów";
+            lines.push_back(line);
+            if (static_cast<int>(line.length()) > maxLineWidth) {
+                maxLineWidth = static_cast<int>(line.length());
+            }
+        }
+
+        // Center the scoreboard
+        int startX = (winBuffer.width - maxLineWidth) / 2;
+        if (startX < 0) startX = 0;
+
+        for (int i = 0; i < count; ++i) {
+            winScreen.drawText(winBuffer, startX, startY + i, lines[i].c_str(), FG_WHITE | 0);
+        }
+
+        if (scores.size() > maxDisplay) {
+            std::wstring more = L"<...pozostałe>";
+            int moreX = (winBuffer.width - static_cast<int>(more.length())) / 2;
+            if (moreX < 0) moreX = 0;
+            winScreen.drawText(winBuffer, moreX, startY + count, more.c_str(), FG_WHITE | 0);
+        }
+
+        winBuffer.render();
+    }
+
+    void stepMenu() {
+        // Keys after the one that starts the game are left for it
+        const InputClock::time_point firstKey = oldestKey();
+        for (KeyEvent event{}; !renderGame && takeKey(event);) {
+            if (activeElement == RESUME) {
+                resumeSelector.handleInput(event);
+            } else if (activeElement == DIFFICULTY) {
+                difficultySelector.handleInput(event);
+            } else if (activeElement == NAME_INPUT) {
+                input.handleInput(event);
+            }
+        }
+
+        // Only widgets whose state changed are drawn, and the screen is
+        // written only if one was
+        bool menuChanged = false;
+        const auto redraw = [this, &menuChanged](auto& widget) {
+            if (!widget.isDirty()) return;
+            widget.render(menuBuffer);
+            widget.markDrawn(widget.bounds());
+            menuChanged = true;
+        };
+        if (canResume) redraw(resumeSelector);
+        redraw(difficultySelector);
+        redraw(input);
+        if (menuChanged) menuBuffer.render(firstKey);
+    }
+};
+
+#endif // SOLITAIREAPP_H
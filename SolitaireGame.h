@@ -9,15 +9,28 @@
 #include <random>
 #include <algorithm>
 #include <stack>
+#include <string>
+#include <cstring>
+#include <utility>
 
 #include "Card.h"
 #include "CardStash.h"
+#include "StockPile.h"
 #include "ConsoleColors.h"
 #include "ScreenBuffer.h"
 #include "Renderable.h"
 #include "TableauPile.h"
 #include "FoundationPile.h"
 #include "Input.h"
+#include "Position.h"
+#include "Rules.h"
+#include "MoveCache.h"
+#include "Endgame.h"
+#include "Timeline.h"
+#include "SaveFile.h"
+#include "ScoreVerifier.h"
+#include "Scene.h"
+#include "Label.h"
 
 struct Selection {
     enum class Type {
@@ -43,8 +56,9 @@ enum class MoveState {
 };
 
 enum class Difficulty {
-    Easy = 0,
-    Hard = 1
+    Easy = 0,  // draw 1
+    Hard = 1,  // draw 3
+    Expert = 2 // draw 3, three passes through the stock
 };
 
 // Structure to store move information for undo functionality
@@ -61,6 +75,7 @@ struct Move {
     std::vector<Card> movedCards;
     bool wasCardFlipped = false;
     int sourceIndex = -1;  // For flip operations
+    size_t stockCursor = 0; // Stock/waste split before a draw or recycle
 
     Move(const Type t) : type(t) {}
     Move(const Type t, const Selection src, const Selection dest, const std::vector<Card>& cards, const bool flipped = false)
@@ -73,18 +88,42 @@ public:
     bool restartRequested = false; // Flag to signal restart request
 
     SolitaireGame(const int width, const int height)
-        : Renderable(width, height), stock(), waste(),
+        : Renderable(width, height), stock(), stockView(), wasteView(),
           foundations(4), tableau(7), difficulty(), moves(0), maxUndoMoves(3), duringSetup(true) {
+        buildScene();
     }
 
+    // The scene points into the game
+    SolitaireGame(const SolitaireGame&) = delete;
+    SolitaireGame& operator=(const SolitaireGame&) = delete;
+
     void setDifficulty(const Difficulty difficulty) {
         this->difficulty = difficulty;
     }
 
+    RuleVariant ruleVariant() const {
+        switch (difficulty) {
+            case Difficulty::Hard:   return RuleVariant::Draw3;
+            case Difficulty::Expert: return RuleVariant::Draw3ThreePasses;
+            default:                 return RuleVariant::Draw1;
+        }
+    }
+
+    // Runs f with the compile-time rule set of the current difficulty
+    template <typename F>
+    decltype(auto) withGameRules(F&& f) const {
+        return withRules(ruleVariant(), std::forward<F>(f));
+    }
+
     void setup() {
+        std::random_device rd;
+        setup((static_cast<uint64_t>(rd()) << 32) | rd());
+    }
+
+    // Deals the game for the given seed
+    void setup(const uint64_t dealSeed) {
         duringSetup = true;
-        stock.cards.clear();
-        waste.cards.clear();
+        stock.reset();
         restartRequested = false;
 
         for (auto& foundation : foundations) {
@@ -95,17 +134,22 @@ public:
             pile.reset();
         }
 
+        seed = dealSeed;
+
         createDeck();
-        shuffleDeck();
         dealToTableau();
 
         // Move remaining cards to stock
-        for (Card& card : allCards) {
-            card.isFaceUp = false;
+        for (const Card& card : allCards) {
             stock.push(card);
         }
 
         moves = 0;
+        recycles = 0;
+        table = dealPosition(seed);
+        withGameRules([this](auto rules) { legalMoves.reset<decltype(rules)>(table); });
+        timeline.reset(table, ruleVariant());
+        timelineCursor = 0;
 
         // Clear move history
         while (!moveHistory.empty()) {
@@ -117,54 +161,87 @@ public:
         destinationSelection.clear();
         moveState = MoveState::SelectingSource;
 
+        scene.invalidate();
         duringSetup = false;
+        changed = true;
     }
 
-    void updateSize(ScreenBuffer& screen) {
-        setSize(screen.width, screen.height);
-        clear(screen);
+    // Whether anything worth saving happened since the last call
+    bool takeChanges() {
+        const bool result = changed;
+        changed = false;
+        return result;
     }
 
-    void render(ScreenBuffer& screen) {
-        clear(screen, BG_GREEN | FG_WHITE);
+    bool save(SaveFile& file, const std::string& playerName) const {
+        SaveHeader header;
+        header.difficulty = static_cast<uint8_t>(difficulty);
+        header.undoDepth = static_cast<uint8_t>(std::min(static_cast<int>(moveHistory.size()), maxUndoMoves));
+        header.seed = seed;
+        header.moves = static_cast<uint32_t>(moves);
+        header.timelineCursor = static_cast<uint32_t>(timelineCursor);
+        header.timelineSize = static_cast<uint32_t>(timeline.size());
+        playerName.copy(header.playerName.data(), header.playerName.size() - 1);
+        header.position = timeline.positionAt(timelineCursor);
+        return file.write(header, timeline.moveData());
+    }
 
-        // Render stock pile
-        stock.clear(screen, BG_GREEN);
-        stock.setPos(2 - stock.renderBorder(), 2 - stock.renderBorder());
-        stock.render(screen);
-        drawText(screen, 4, 9, "[Q]", getSelectionColor(Selection::Type::Stock, 0));
+    // The game on the table as a score to verify: the deal and every move
+    ScoreSubmission scoreSubmission(const std::string& playerName) const {
+        const EngineMove* log = timeline.moveData();
+        return {playerName, seed, ruleVariant(), moves, std::vector<EngineMove>(log, log + timelineCursor)};
+    }
 
-        // Render waste pile
-        waste.clear(screen, BG_GREEN);
-        waste.setPos(12 - waste.renderBorder(), 2 - waste.renderBorder());
-        waste.render(screen);
-        drawText(screen, 14, 9, "[W]", getSelectionColor(Selection::Type::Waste, 0));
+    // Continues a saved game. The moves are replayed from the deal and must
+    // end on the saved table; the last few go through the normal move path
+    // so they can be undone again.
+    bool resume(const SaveData& data) {
+        const SaveHeader& header = data.header;
+        if (header.difficulty > static_cast<uint8_t>(Difficulty::Expert) || header.moves != header.timelineCursor) {
+            return false;
+        }
 
-        // Render foundation piles
-        for (int i = 0; i < 4; i++) {
-            const int fx = 32 + i * 10;
-            const std::string labels[4] = { "[E]", "[R]", "[T]", "[Y]" };
-            drawText(screen, fx + 2, 9, labels[i], getSelectionColor(Selection::Type::Foundation, i));
+        setDifficulty(static_cast<Difficulty>(header.difficulty));
+        setup(header.seed);
 
-            foundations[i].setPos(fx, 2);
-            foundations[i].render(screen);
+        for (const EngineMove& move : data.moves) {
+            const bool legal = withGameRules([&](auto rules) {
+                return isLegalMove<decltype(rules)>(timeline.latest(), move);
+            });
+            if (!legal) {
+                setup();
+                return false;
+            }
+            timeline.push(move);
         }
 
-        // Render tableau piles
-        for (int i = 0; i < 7; i++) {
-            const int px = 2 + i * 10;
-            std::string label = "[" + std::to_string(i + 1) + "]";
-            drawText(screen, px + 2, 11, label, getSelectionColor(Selection::Type::Tableau, i));
+        const Position reached = timeline.positionAt(header.timelineCursor);
+        if (std::memcmp(&reached, &header.position, sizeof(Position)) != 0) {
+            setup();
+            return false;
+        }
 
-            tableau[i].setPos(px, 12);
-            tableau[i].setSelected(sourceSelection.type == Selection::Type::Tableau && sourceSelection.index == i, sourceSelection.cardIndex);
-            tableau[i].render(screen);
+        const size_t undoDepth = std::min<size_t>({header.undoDepth, header.timelineCursor, static_cast<size_t>(maxUndoMoves)});
+        seekTimeline(header.timelineCursor - undoDepth);
+        for (size_t i = timelineCursor; i < header.timelineCursor; i++) {
+            playEngineMove(timeline.moveAt(i));
         }
 
-        renderStateInfo(screen);
-        renderMoveCount(screen);
-        renderUndoInfo(screen);
-        renderRestartInfo(screen); // Add restart info
+        changed = false;
+        return true;
+    }
+
+    void updateSize(ScreenBuffer& screen) {
+        setSize(screen.width, screen.height);
+        layoutHud();
+        scene.invalidate();
+    }
+
+    // Brings the scene up to date with the game and draws only what changed.
+    // Returns false when nothing did, so the frame need not be written out.
+    bool render(ScreenBuffer& screen) {
+        syncScene();
+        return scene.render(screen, BG_GREEN | FG_WHITE) > 0;
     }
 
     void handleInput(const KeyEvent& input) {
@@ -178,9 +255,17 @@ public:
             } else if (std::toupper(input.ch) == 'U') {
                 // Undo move (limit to 3 moves back)
                 undoLastMove();
-            } else if (std::toupper(input.ch) == 'R') {
+            } else if (std::toupper(input.ch) == 'P') {
                 // Restart game
                 restartRequested = true;
+            } else if (std::toupper(input.ch) == 'F' && moveState == MoveState::SelectingSource) {
+                autoFinish();
+            } else if (input.ch == ',' && moveState == MoveState::SelectingSource) {
+                // Rewind one move in the timeline
+                if (timelineCursor > 0) seekTimeline(timelineCursor - 1);
+            } else if (input.ch == '.' && moveState == MoveState::SelectingSource) {
+                // Replay one rewound move
+                if (timelineCursor < timeline.size()) seekTimeline(timelineCursor + 1);
             } else if (moveState == MoveState::SelectingSource) {
                 handleSourceSelection(input.ch);
             } else if (moveState == MoveState::SelectingDestination) {
@@ -197,54 +282,73 @@ public:
         }
     }
 
-    bool isWin() const {
-        if (duringSetup) return false;
-
-        // Check if all four foundation piles are complete (Ace to King = 13 cards each)
-        for (const auto& foundation : foundations) {
-            if (foundation.size() != 13) {
-                return false;
-            }
-
-            // Verify the top card is a King
-            if (!foundation.empty() && foundation.peek().rank != Rank::King) {
-                return false;
-            }
-        }
+    uint64_t getSeed() const {
+        return seed;
+    }
 
-        return true; // All foundations are complete
+    bool isWin() const {
+        return !duringSetup && table.isWin();
     }
 
 private:
     std::vector<Card> allCards;
-    CardStash stock;
-    CardStash waste;
+    StockPile stock;
+    CardStash stockView;
+    CardStash wasteView;
     std::vector<FoundationPile> foundations;
     std::vector<TableauPile> tableau;
     MoveState moveState = MoveState::SelectingSource;
     Selection sourceSelection;
     Selection destinationSelection;
     Difficulty difficulty;
+    uint64_t seed = 0;
     std::stack<Move> moveHistory;
+    Timeline timeline;         // every move of the game, for rewinding
+    size_t timelineCursor = 0; // moves of the timeline currently on the table
+    Position table;            // the piles as the engine sees them, for rule checks
+    MoveCache legalMoves;      // moves legal on the table, updated with every move
+    bool changed = false;      // not saved yet
+    int recycles = 0;          // waste turned back into stock, counted only under limited passes
     const int maxUndoMoves; // Limit to 3 undo moves
     bool duringSetup;
 
+    // What the text rows show; their strings are rebuilt only when it changes
+    struct HudState {
+        MoveState moveState = MoveState::SelectingSource;
+        int moves = -1; // nothing shown yet
+        size_t timelineCursor = 0;
+        size_t timelineSize = 0;
+        int undoCount = 0;
+        int recycles = 0;
+        int maxPasses = 0;
+        bool canFinish = false;
+
+        bool operator==(const HudState&) const = default;
+    };
+
+    // Retained scene: piles and labels are redrawn only when they change
+    Scene scene;
+    Label stockLabel;
+    Label wasteLabel;
+    Label passLabel;
+    std::array<Label, FOUNDATION_PILES> foundationLabels;
+    std::array<Label, TABLEAU_COLUMNS> tableauLabels;
+    Label stateLabel;
+    Label moveLabel;
+    Label undoLabel;
+    Label restartLabel;
+    Label finishLabel;
+    HudState shownHud;
+
     void createDeck() {
         allCards.clear();
-        // Create standard 52-card deck: A, 2, 3, 4, 5, 6, 7, 8, 9, 10, J, Q, K for each suit
-        for (int s = 0; s < 4; ++s) {
-            for (int r = 1; r <= 13; ++r) { // Changed from r = 2 to r = 1 to include Ace
-                allCards.emplace_back(static_cast<Suit>(s), static_cast<Rank>(r));
-            }
+        // Standard 52-card deck in the order the seed shuffles it, so the same
+        // seed deals the same game here and in the headless engine
+        for (const CardId id : shuffledDeck(seed)) {
+            allCards.emplace_back(cardSuit(id), cardRank(id));
         }
     }
 
-    void shuffleDeck() {
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::ranges::shuffle(allCards, g);
-    }
-
     void dealToTableau() {
         int index = 0;
         for (int i = 0; i < 7; ++i) {
@@ -264,36 +368,172 @@ private:
         return FG_WHITE | BG_BLUE;
     }
 
-    void renderStateInfo(ScreenBuffer& screen) const {
-        std::wstring stateText;
-        switch (moveState) {
-            case MoveState::SelectingSource:
-                stateText = L"Wybierz stos [Q/W/E/R/T/Y/1-7] | Cofnij ruch [U] | Restart [R]";
-                break;
-            case MoveState::SelectingCard:
-                stateText = L"Użyj strzałek aby wybrać karte, zatwierdź [Enter] lub odrzuć [Q]";
-                break;
-            case MoveState::SelectingDestination:
-                stateText = L"Wybierz stos docelowy [Q/W/E/R/T/Y/1-7] lub anuluj [Q]";
-                break;
+    // Adds every node in drawing order and places the ones that never move
+    void buildScene() {
+        stockLabel.setText(L"[Q]", FG_WHITE | BG_BLUE);
+        stockLabel.setPos(4, 9);
+        wasteLabel.setText(L"[W]", FG_WHITE | BG_BLUE);
+        wasteLabel.setPos(14, 9);
+        passLabel.setPos(2, 10);
+        restartLabel.setText(L"Restart [P]", FG_MAGENTA | 0);
+        finishLabel.setText(L"Dokończ [F]", FG_BRIGHT_GREEN | 0);
+        stateLabel.setPos(1, 0);
+
+        scene.add(stockView);
+        scene.add(stockLabel);
+        scene.add(wasteView);
+        scene.add(wasteLabel);
+        scene.add(passLabel);
+
+        const wchar_t* foundationKeys[FOUNDATION_PILES] = { L"[E]", L"[R]", L"[T]", L"[Y]" };
+        for (int i = 0; i < FOUNDATION_PILES; i++) {
+            const int fx = 32 + i * 10;
+            foundationLabels[i].setText(foundationKeys[i], FG_WHITE | BG_BLUE);
+            foundationLabels[i].setPos(fx + 2, 9);
+            foundations[i].setPos(fx, 2);
+            scene.add(foundationLabels[i]);
+            scene.add(foundations[i]);
+        }
+
+        for (int i = 0; i < TABLEAU_COLUMNS; i++) {
+            const int px = 2 + i * 10;
+            tableauLabels[i].setText(L"[" + std::to_wstring(i + 1) + L"]", FG_WHITE | BG_BLUE);
+            tableauLabels[i].setPos(px + 2, 11);
+            tableau[i].setPos(px, 12);
+            scene.add(tableauLabels[i]);
+            scene.add(tableau[i]);
+        }
+
+        scene.add(stateLabel);
+        scene.add(moveLabel);
+        scene.add(undoLabel);
+        scene.add(restartLabel);
+        scene.add(finishLabel);
+        layoutHud();
+    }
+
+    // Feeds the state the piles do not track themselves into the scene;
+    // setters mark a node dirty only if what it shows changes
+    void syncScene() {
+        stockView.setContents(stock.stockEmpty() ? nullptr : &stock.peekStock(), stock.stockSize(), false);
+        stockView.setPos(2 - stockView.renderBorder(), 2 - stockView.renderBorder());
+        wasteView.setContents(stock.wasteEmpty() ? nullptr : &stock.peekWaste(), stock.wasteSize(), true);
+        wasteView.setPos(12 - wasteView.renderBorder(), 2 - wasteView.renderBorder());
+
+        stockLabel.setColor(getSelectionColor(Selection::Type::Stock, 0));
+        wasteLabel.setColor(getSelectionColor(Selection::Type::Waste, 0));
+        for (int i = 0; i < FOUNDATION_PILES; i++) {
+            foundationLabels[i].setColor(getSelectionColor(Selection::Type::Foundation, i));
+        }
+        for (int i = 0; i < TABLEAU_COLUMNS; i++) {
+            tableauLabels[i].setColor(getSelectionColor(Selection::Type::Tableau, i));
+            tableau[i].setSelected(sourceSelection.type == Selection::Type::Tableau && sourceSelection.index == i, sourceSelection.cardIndex);
+        }
+
+        EndgameOrder order;
+        const HudState hud{
+            moveState, moves, timelineCursor, timeline.size(),
+            std::min(static_cast<int>(moveHistory.size()), maxUndoMoves), recycles,
+            withGameRules([](auto rules) { return decltype(rules)::maxPasses; }), canAutoFinish(order)
+        };
+        if (hud != shownHud) updateHud(hud);
+    }
+
+    void updateHud(const HudState& hud) {
+        const bool first = shownHud.moves < 0;
+
+        if (first || hud.moveState != shownHud.moveState) {
+            switch (hud.moveState) {
+                case MoveState::SelectingSource:
+                    stateLabel.setText(L"Wybierz stos [Q/W/E/R/T/Y/1-7] | Cofnij ruch [U] | Przewiń [,/.] | Restart [P]", FG_WHITE | 0);
+                    break;
+                case MoveState::SelectingCard:
+                    stateLabel.setText(L"Użyj strzałek aby wybrać karte, zatwierdź [Enter] lub odrzuć [Q]", FG_WHITE | 0);
+                    break;
+                case MoveState::SelectingDestination:
+                    stateLabel.setText(L"Wybierz stos docelowy [Q/W/E/R/T/Y/1-7] lub anuluj [Q]", FG_WHITE | 0);
+                    break;
+            }
+        }
+
+        if (first || hud.moves != shownHud.moves || hud.timelineCursor != shownHud.timelineCursor ||
+            hud.timelineSize != shownHud.timelineSize) {
+            std::wstring moveText = L"Ruchy: " + std::to_wstring(hud.moves);
+            if (hud.timelineCursor < hud.timelineSize) {
+                moveText += L"/" + std::to_wstring(hud.timelineSize); // rewound
+            }
+            moveLabel.setText(moveText, FG_YELLOW | 0);
+        }
+
+        if (first || hud.undoCount != shownHud.undoCount) {
+            undoLabel.setText(L"Cofnij: " + std::to_wstring(hud.undoCount) + L"/" + std::to_wstring(maxUndoMoves), FG_CYAN | 0);
+        }
+
+        // Current pass through the stock, only when passes are limited
+        if (first || hud.recycles != shownHud.recycles || hud.maxPasses != shownHud.maxPasses) {
+            passLabel.setVisible(hud.maxPasses != 0);
+            if (hud.maxPasses != 0) {
+                passLabel.setText(L"Przejście " + std::to_wstring(hud.recycles + 1) + L"/" + std::to_wstring(hud.maxPasses), FG_WHITE | BG_GREEN);
+            }
         }
-        drawText(screen, 1, 0, stateText, FG_WHITE | 0);
+
+        finishLabel.setVisible(hud.canFinish);
+        shownHud = hud;
+        layoutHud();
+    }
+
+    // Right-aligned rows follow the screen width and their text length
+    void layoutHud() {
+        const auto alignRight = [this](Label& label, const int row) {
+            label.setPos(width - static_cast<int>(label.getText().length()) - 2, row);
+        };
+        alignRight(moveLabel, 0);
+        alignRight(undoLabel, 1);
+        alignRight(restartLabel, 2);
+        alignRight(finishLabel, 3);
     }
 
-    void renderMoveCount(ScreenBuffer& screen) const {
-        const std::wstring moveText = L"Ruchy: " + std::to_wstring(moves);
-        drawText(screen, width - static_cast<int>(moveText.length()) - 2, 0, moveText, FG_YELLOW | 0);
+    // Stock and waste used up and every card face up: the game can be played
+    // out to the foundations automatically
+    bool canAutoFinish(EndgameOrder& order) const {
+        if (duringSetup || isWin() || !stock.stockEmpty() || !stock.wasteEmpty()) return false;
+        return solveEndgame(tableau, foundations, order);
     }
 
-    void renderUndoInfo(ScreenBuffer& screen) const {
-        const int undoCount = std::min(static_cast<int>(moveHistory.size()), maxUndoMoves);
-        const std::wstring undoText = L"Cofnij: " + std::to_wstring(undoCount) + L"/" + std::to_wstring(maxUndoMoves);
-        drawText(screen, width - static_cast<int>(undoText.length()) - 2, 1, undoText, FG_CYAN | 0);
+    void autoFinish() {
+        EndgameOrder order;
+        if (!canAutoFinish(order)) return;
+
+        for (int i = 0; i < order.count; i++) {
+            playEngineMove(order.moves[i]);
+        }
     }
 
-    void renderRestartInfo(ScreenBuffer& screen) const {
-        const std::wstring restartText = L"Restart [R]";
-        drawText(screen, width - static_cast<int>(restartText.length()) - 2, 2, restartText, FG_MAGENTA | 0);
+    // Makes an engine move through the same path as a player's move
+    bool playEngineMove(const EngineMove& move) {
+        using Type = EngineMove::Type;
+        const auto lastCard = [this](const int column, const int count) {
+            return static_cast<int>(tableau[column].size()) - count;
+        };
+
+        switch (move.type) {
+            case Type::Draw:
+            case Type::Recycle:
+                return drawFromStock();
+            case Type::WasteToFoundation:
+                return tryMove({ Selection::Type::Waste, 0 }, { Selection::Type::Foundation, move.to });
+            case Type::WasteToTableau:
+                return tryMove({ Selection::Type::Waste, 0 }, { Selection::Type::Tableau, move.to });
+            case Type::TableauToFoundation:
+                return tryMove({ Selection::Type::Tableau, move.from, lastCard(move.from, 1) },
+                               { Selection::Type::Foundation, move.to });
+            case Type::TableauToTableau:
+                return tryMove({ Selection::Type::Tableau, move.from, lastCard(move.from, move.count) },
+                               { Selection::Type::Tableau, move.to });
+            case Type::FoundationToTableau:
+                return tryMove({ Selection::Type::Foundation, move.from }, { Selection::Type::Tableau, move.to });
+        }
+        return false;
     }
 
     void handleSourceSelection(const char ch) {
@@ -360,10 +600,10 @@ private:
             sourceSelection.cardIndex++;
         }
 
-        // Ensure we can only select from face-up cards
-        while (sourceSelection.cardIndex < maxCards - 1 &&
-               !tableau[pileIndex].get(sourceSelection.cardIndex).isFaceUp) {
-            sourceSelection.cardIndex++;
+        // Ensure we can only select from the movable face-up run
+        const int runStart = static_cast<int>(tableau[pileIndex].movableRunStart());
+        if (sourceSelection.cardIndex < runStart) {
+            sourceSelection.cardIndex = std::min(runStart, maxCards - 1);
         }
     }
 
@@ -414,9 +654,11 @@ private:
             case Selection::Type::Stock:
                 return true;
             case Selection::Type::Waste:
-                return !waste.empty();
+                return !stock.wasteEmpty();
             case Selection::Type::Foundation:
-                return !foundations[selection.index].empty();
+                // A foundation card can only go back to the tableau
+                return !foundations[selection.index].empty() &&
+                       withGameRules([](auto rules) { return decltype(rules)::foundationToTableau; });
             case Selection::Type::Tableau:
                 return !tableau[selection.index].empty();
             default:
@@ -430,12 +672,23 @@ private:
             return drawFromStock();
         }
 
+        // Moving an Ace between empty foundations changes nothing
+        if (source.type == Selection::Type::Foundation && dest.type == Selection::Type::Foundation) {
+            return false;
+        }
+
+        if (dest.type != Selection::Type::Foundation && dest.type != Selection::Type::Tableau) {
+            return false;
+        }
+
         std::vector<Card> cardsToMove;
         if (!getCardsToMove(source, cardsToMove)) {
             return false;
         }
 
-        if (!isValidMove(cardsToMove, dest)) {
+        // A lookup in the moves kept for the table, not a check from scratch
+        const EngineMove engineMove = toEngineMove(source, dest, cardsToMove.size());
+        if (!legalMoves.isLegal(table, engineMove)) {
             return false;
         }
 
@@ -458,6 +711,7 @@ private:
 
         moves++;
         moveHistory.push(move);
+        recordMove(engineMove);
 
         // Limit undo history to maxUndoMoves
         limitUndoHistory();
@@ -466,45 +720,26 @@ private:
     }
 
     bool drawFromStock() {
-        if (stock.empty()) {
-            // Reshuffle waste back to stock
-            if (waste.empty()) return false;
+        if (stock.stockEmpty()) {
+            // Turn the waste over to become the stock again, if the rules allow another pass
+            if (stock.wasteEmpty()) return false;
+            const bool counted = withGameRules([](auto rules) { return decltype(rules)::countsRecycles; });
+            const bool allowed = withGameRules([this](auto rules) { return decltype(rules)::canRecycle(recycles); });
+            if (!allowed) return false;
 
             Move move(Move::Type::WasteToStock);
-            std::vector<Card> wasteCards;
-
-            // Collect all waste cards
-            while (!waste.empty()) {
-                Card card = waste.peek();
-                card.isFaceUp = false;
-                wasteCards.push_back(card);
-                waste.pop();
-            }
-
-            // Shuffle the cards before putting them back to stock
-            std::random_device rd;
-            std::mt19937 g(rd());
-            std::ranges::shuffle(wasteCards, g);
+            move.stockCursor = stock.getCursor();
+            stock.recycle();
+            if (counted) recycles++;
 
-            // Add shuffled cards to stock
-            for (const Card& card : wasteCards) {
-                stock.push(card);
-            }
-
-            move.movedCards = wasteCards;
             moves++;
             moveHistory.push(move);
+            recordMove({ EngineMove::Type::Recycle });
             limitUndoHistory();
         } else {
             // Draw cards from stock to waste based on difficulty
-            if (difficulty == Difficulty::Easy) {
-                // Easy: Draw 1 card
-                drawCardsFromStock(1);
-            } else {
-                // Hard: Draw 3 cards (or remaining cards if less than 3)
-                const int cardsToDraw = std::min(3, static_cast<int>(stock.size()));
-                drawCardsFromStock(cardsToDraw);
-            }
+            // Easy: Draw 1 card, Hard: Draw 3 cards (or remaining cards if less than 3)
+            drawCardsFromStock(withGameRules([](auto rules) { return decltype(rules)::drawCount; }));
         }
 
         return true;
@@ -512,20 +747,92 @@ private:
 
     void drawCardsFromStock(const int numCards) {
         Move move(Move::Type::StockToWaste);
-
-        for (int i = 0; i < numCards && !stock.empty(); i++) {
-            Card card = stock.peek();
-            card.isFaceUp = true;
-            move.movedCards.push_back(card);
-            stock.pop();
-            waste.push(card);
-        }
+        move.stockCursor = stock.getCursor();
+        stock.draw(numCards);
 
         moves++;
         moveHistory.push(move);
+        recordMove({ EngineMove::Type::Draw });
         limitUndoHistory();
     }
 
+    static EngineMove toEngineMove(const Selection& source, const Selection& dest, const size_t count) {
+        using Type = EngineMove::Type;
+        const bool toFoundation = dest.type == Selection::Type::Foundation;
+        const auto from = static_cast<uint8_t>(source.index);
+        const auto to = static_cast<uint8_t>(dest.index);
+
+        switch (source.type) {
+            case Selection::Type::Waste:
+                return { toFoundation ? Type::WasteToFoundation : Type::WasteToTableau, 0, to, 1 };
+            case Selection::Type::Foundation:
+                return { Type::FoundationToTableau, from, to, 1 };
+            default:
+                return { toFoundation ? Type::TableauToFoundation : Type::TableauToTableau, from, to,
+                         static_cast<uint8_t>(count) };
+        }
+    }
+
+    // A move made after rewinding replaces the rewound part of the timeline,
+    // unless it is the same move the timeline already has next
+    void recordMove(const EngineMove& move) {
+        if (timelineCursor == timeline.size() || !(timeline.moveAt(timelineCursor) == move)) {
+            timeline.truncate(timelineCursor);
+            timeline.push(move);
+        }
+        timelineCursor++;
+        withGameRules([&](auto rules) { legalMoves.apply<decltype(rules)>(table, move); });
+        changed = true;
+    }
+
+    void seekTimeline(const size_t index) {
+        table = timeline.positionAt(index);
+        withGameRules([this](auto rules) { legalMoves.reset<decltype(rules)>(table); });
+        loadPosition(table);
+        timelineCursor = index;
+        moves = static_cast<int>(index);
+        changed = true;
+
+        // Undo steps describe the table before the jump
+        while (!moveHistory.empty()) {
+            moveHistory.pop();
+        }
+        sourceSelection.clear();
+        destinationSelection.clear();
+    }
+
+    // Rebuilds all piles from an engine position
+    void loadPosition(const Position& pos) {
+        const auto toCard = [](const CardId id, const bool faceUp) {
+            Card card(cardSuit(id), cardRank(id));
+            card.isFaceUp = faceUp;
+            return card;
+        };
+
+        for (int i = 0; i < TABLEAU_COLUMNS; i++) {
+            tableau[i].reset();
+            for (int j = 0; j < pos.columnSize[i]; j++) {
+                tableau[i].push(toCard(pos.tableau[i][j], j >= pos.faceDown[i]));
+            }
+        }
+
+        for (int i = 0; i < FOUNDATION_PILES; i++) {
+            foundations[i].reset();
+            const CardId top = pos.foundation[i];
+            if (top == NO_CARD) continue;
+            for (CardId id = top - (rankValue(top) - 1); id <= top; id++) {
+                foundations[i].push(toCard(id, true));
+            }
+        }
+
+        stock.reset();
+        for (int i = 0; i < pos.stockSize; i++) {
+            stock.push(toCard(pos.stock[i], false));
+        }
+        stock.setCursor(pos.cursor);
+        recycles = pos.recycles;
+    }
+
     void limitUndoHistory() {
         // Keep only the last maxUndoMoves moves
         std::stack<Move> tempStack;
@@ -557,30 +864,12 @@ private:
 
         switch (lastMove.type) {
             case Move::Type::StockToWaste:
-                // Move cards back from waste to stock
-                for (int i = lastMove.movedCards.size() - 1; i >= 0; i--) {
-                    if (!waste.empty()) {
-                        Card card = waste.peek();
-                        card.isFaceUp = false;
-                        waste.pop();
-                        stock.push(card);
-                    }
-                }
+                stock.setCursor(lastMove.stockCursor);
                 break;
 
             case Move::Type::WasteToStock:
-                // Move cards back from stock to waste (reverse the reshuffle)
-                for (const Card& card : lastMove.movedCards) {
-                    if (!stock.empty()) {
-                        stock.pop();
-                    }
-                }
-                // Add cards back to waste in original order
-                for (int i = lastMove.movedCards.size() - 1; i >= 0; i--) {
-                    Card card = lastMove.movedCards[i];
-                    card.isFaceUp = true;
-                    waste.push(card);
-                }
+                stock.setCursor(lastMove.stockCursor);
+                if (recycles > 0) recycles--;
                 break;
 
             case Move::Type::CardMove:
@@ -592,6 +881,14 @@ private:
                 break;
         }
 
+        if (timelineCursor > 0) {
+            const EngineMove undone = timeline.moveAt(--timelineCursor);
+            timeline.truncate(timelineCursor);
+            table = timeline.latest();
+            withGameRules([&](auto rules) { legalMoves.update<decltype(rules)>(table, undone); });
+            changed = true;
+        }
+
         moves--;
         if (moves < 0) moves = 0;
     }
@@ -621,7 +918,7 @@ private:
         switch (move.source.type) {
             case Selection::Type::Waste:
                 for (const Card& card : move.movedCards) {
-                    waste.push(card);
+                    stock.pushWaste(card);
                 }
                 break;
             case Selection::Type::Foundation:
@@ -630,15 +927,15 @@ private:
                 }
                 break;
             case Selection::Type::Tableau:
+                // If a card was flipped during the original move, flip it back
+                // while it is still the top card
+                if (move.wasCardFlipped && move.sourceIndex >= 0 &&
+                    move.sourceIndex + 1 == static_cast<int>(tableau[move.source.index].size())) {
+                    tableau[move.source.index].unflipTopCard();
+                }
                 for (const Card& card : move.movedCards) {
                     tableau[move.source.index].push(card);
                 }
-                // If a card was flipped during the original move, flip it back
-                if (move.wasCardFlipped && move.sourceIndex >= 0) {
-                    if (move.sourceIndex < tableau[move.source.index].size()) {
-                        tableau[move.source.index].get(move.sourceIndex).isFaceUp = false;
-                    }
-                }
                 break;
             default:
                 break;
@@ -649,14 +946,11 @@ private:
         cardsToMove.clear();
 
         switch (source.type) {
-            case Selection::Type::Stock:
-                if (!stock.empty()) {
-                    cardsToMove.push_back(stock.peek());
-                }
-                break;
             case Selection::Type::Waste:
-                if (!waste.empty()) {
-                    cardsToMove.push_back(waste.peek());
+                if (!stock.wasteEmpty()) {
+                    Card card = stock.peekWaste();
+                    card.isFaceUp = true;
+                    cardsToMove.push_back(card);
                 }
                 break;
             case Selection::Type::Foundation:
@@ -667,6 +961,7 @@ private:
             case Selection::Type::Tableau:
                 {
                     const TableauPile& pile = tableau[source.index];
+                    if (!pile.isValidSequence(source.cardIndex)) return false;
                     for (int i = source.cardIndex; i < pile.size(); i++) {
                         cardsToMove.push_back(pile.get(i));
                     }
@@ -679,66 +974,10 @@ private:
         return !cardsToMove.empty();
     }
 
-    bool isValidMove(const std::vector<Card>& cards, const Selection& dest) const {
-        if (cards.empty()) return false;
-
-        const Card& bottomCard = cards[0];
-
-        if (dest.type == Selection::Type::Foundation && cards.size() > 1)
-            return false;
-
-        switch (dest.type) {
-            case Selection::Type::Foundation:
-                return isValidFoundationMove(bottomCard, dest.index);
-            case Selection::Type::Tableau:
-                return isValidTableauMove(cards, dest.index);
-            default:
-                return false;
-        }
-    }
-
-    bool isValidFoundationMove(const Card& card, const int foundationIndex) const {
-        const auto& foundation = foundations[foundationIndex];
-
-        if (foundation.empty()) {
-            return card.rank == Rank::Ace; // Foundation must start with Ace
-        }
-
-        const Card& topCard = foundation.peek();
-
-        // Must be same suit
-        if (card.suit != topCard.suit) {
-            return false;
-        }
-
-        // Must be next rank in sequence (Ace=1, Two=2, ..., King=13)
-        return static_cast<int>(card.rank) == static_cast<int>(topCard.rank) + 1;
-    }
-
-    bool isValidTableauMove(const std::vector<Card>& cards, const int tableauIndex) const {
-        const Card& bottomCard = cards[0];
-        const TableauPile& targetPile = tableau[tableauIndex];
-
-        if (targetPile.empty()) {
-            return bottomCard.rank == Rank::King; // Empty tableau pile must start with King
-        }
-
-        const Card& topCard = targetPile.get(targetPile.size() - 1);
-        const bool isBottomRed = (bottomCard.suit == Suit::Hearts || bottomCard.suit == Suit::Diamonds);
-        const bool isTopRed = (topCard.suit == Suit::Hearts || topCard.suit == Suit::Diamonds);
-        const bool oppositeColors = isBottomRed != isTopRed;
-        const bool correctRank = static_cast<int>(bottomCard.rank) + 1 == static_cast<int>(topCard.rank);
-
-        return oppositeColors && correctRank;
-    }
-
     void removeCardsFromSource(const Selection& source) {
         switch (source.type) {
-            case Selection::Type::Stock:
-                stock.pop();
-                break;
             case Selection::Type::Waste:
-                waste.pop();
+                stock.popWaste();
                 break;
             case Selection::Type::Foundation:
                 foundations[source.index].pop();
@@ -0,0 +1,275 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_set>
+#include <vector>
+
+#include "Arena.h"
+#include "Canonical.h"
+#include "Endgame.h"
+#include "Position.h"
+#include "Rules.h"
+#include "SpillingMemo.h"
+#include "TranspositionTable.h"
+
+enum class SolveResult {
+    Solved,
+    Unsolvable,
+    Unknown // gave up at the node limit
+};
+
+struct SolverOptions {
+    size_t nodeLimit = 2'000'000;
+    Canonicalization canonical = Canonicalization::Columns;
+    TranspositionTable* table = nullptr; // shared visited set instead of a private one
+    SpillingMemo* memo = nullptr;        // bounded-memory visited set that spills to disk
+    const std::atomic<bool>* stop = nullptr;
+    uint32_t orderSeed = 0;              // non-zero shuffles move order (helper threads)
+};
+
+struct SolverStats {
+    size_t nodes = 0;          // positions reached by applying a move
+    size_t transpositions = 0; // of those, already visited
+    size_t maxDepth = 0;
+    size_t memoryBytes = 0;    // arena memory the search took
+};
+
+struct SolverOutcome {
+    SolveResult result = SolveResult::Unknown;
+    std::vector<EngineMove> solution;
+    SolverStats stats;
+};
+
+// Depth-first search over a perfect-information deal (face-down cards known)
+// with a visited-position set, instantiated per rule set (see Rules.h). All
+// search memory comes from the calling thread's arena and is released in
+// bulk when solve() returns.
+//
+// With options.table set, visited positions go to a TranspositionTable that
+// other threads may share; the caller starts each search with newSearch().
+// With options.memo set they go to a SpillingMemo instead. Children are then
+// marked when their parent is expanded, so each node's children are looked
+// up as one batch.
+template <typename Rules>
+class Solver {
+public:
+    static constexpr size_t MAX_DEPTH = 1024;
+
+    explicit Solver(const SolverOptions& options = {}) : options(options) {}
+
+    SolverOutcome solve(const Position& start) const {
+        MonotonicArena& arena = MonotonicArena::forThread();
+        ArenaScope scope(arena);
+        const size_t allocatedBefore = arena.getStats().bytesAllocated;
+
+        SolverOutcome outcome;
+        SolverStats& stats = outcome.stats;
+
+        std::pmr::unordered_set<uint64_t> visited(&arena);
+        if (!options.table) visited.reserve(std::min<size_t>(options.nodeLimit, 1 << 20));
+
+        ArenaVector<Frame> stack(&arena);
+        stack.reserve(256);
+
+        const auto markVisited = [&](const uint64_t key, const size_t depth) {
+            if (options.memo) {
+                return options.memo->insert(key);
+            }
+            if (options.table) {
+                return options.table->insert(key, static_cast<uint8_t>(255 - std::min<size_t>(depth, 255)));
+            }
+            return visited.insert(key).second;
+        };
+
+        Position pos = start;
+        uint32_t rng = options.orderSeed;
+        const auto expand = [&](Frame& frame) {
+            frame.moveCount = static_cast<uint8_t>(orderedMoves(pos, frame.moves.data()));
+            if (rng) shuffleMoves(frame, rng);
+            if (options.memo) stats.transpositions += dropVisitedChildren(pos, frame, *options.memo);
+        };
+
+        // Without a private visited set a path can outlive its table entries,
+        // so depth is capped and hitting the cap makes the answer unknown
+        bool depthCut = false;
+
+        markVisited(canonicalHash(pos, options.canonical), 0);
+        expand(stack.emplace_back());
+
+        EndgameOrder endgame;
+        while (!stack.empty()) {
+            // Everything revealed and the stock used up: the rest is a straight
+            // run to the foundations, no need to search it
+            if (solveEndgame(pos, endgame)) {
+                for (size_t i = 1; i < stack.size(); i++) {
+                    outcome.solution.push_back(stack[i].applied.move);
+                }
+                outcome.solution.insert(outcome.solution.end(), endgame.moves.begin(), endgame.moves.begin() + endgame.count);
+                outcome.result = SolveResult::Solved;
+                stats.memoryBytes = arena.getStats().bytesAllocated - allocatedBefore;
+                return outcome;
+            }
+
+            Frame& top = stack.back();
+            if (top.next == top.moveCount) {
+                if (stack.size() > 1) undoMove<Rules>(pos, top.applied);
+                stack.pop_back();
+                continue;
+            }
+
+            const EngineMove move = top.moves[top.next++];
+            const MoveRecord record = applyMove<Rules>(pos, move);
+
+            if (++stats.nodes > options.nodeLimit ||
+                (options.stop && (stats.nodes & 1023) == 0 && options.stop->load(std::memory_order_relaxed))) {
+                outcome.result = SolveResult::Unknown;
+                stats.memoryBytes = arena.getStats().bytesAllocated - allocatedBefore;
+                return outcome;
+            }
+
+            if (!options.memo && !markVisited(canonicalHash(pos, options.canonical), stack.size())) {
+                stats.transpositions++;
+                undoMove<Rules>(pos, record);
+                continue;
+            }
+
+            Frame& frame = stack.emplace_back();
+            frame.applied = record;
+            if (stack.size() > MAX_DEPTH && !isEndgame(pos)) {
+                depthCut = true; // leaf: frame keeps no moves
+            } else {
+                expand(frame);
+            }
+            stats.maxDepth = std::max(stats.maxDepth, stack.size() - 1);
+        }
+
+        outcome.result = depthCut ? SolveResult::Unknown : SolveResult::Unsolvable;
+        stats.memoryBytes = arena.getStats().bytesAllocated - allocatedBefore;
+        return outcome;
+    }
+
+    // Every legal move that can matter, most promising first. A safe move
+    // from the tableau to a foundation is returned alone since playing it
+    // never loses the game. From the waste it is only ordered first: taking
+    // a card out of the waste regroups the stock on every later pass, which
+    // can lose a draw-3 game. A whole column moved onto an empty column is
+    // left out, the position is the same with the columns swapped.
+    static int orderedMoves(const Position& pos, EngineMove* out) {
+        std::array<EngineMove, Rules::maxMoves> legal;
+        const int legalCount = generateMoves<Rules>(pos, legal.data());
+
+        int count = 0;
+        std::array<EngineMove, Rules::maxMoves> later;
+        int laterCount = 0;
+        std::array<EngineMove, Rules::maxMoves> last;
+        int lastCount = 0;
+
+        for (int i = 0; i < legalCount; i++) {
+            const EngineMove& move = legal[i];
+
+            switch (move.type) {
+                case EngineMove::Type::WasteToFoundation:
+                    out[count++] = move;
+                    if (isSafeFoundationMove(pos, pos.wasteTop())) std::swap(out[0], out[count - 1]);
+                    break;
+                case EngineMove::Type::TableauToFoundation:
+                    if (isSafeFoundationMove(pos, pos.columnTop(move.from))) {
+                        out[0] = move;
+                        return 1;
+                    }
+                    out[count++] = move;
+                    break;
+                case EngineMove::Type::TableauToTableau: {
+                    const int faceUp = pos.countFaceUp(move.from);
+                    if (move.count == faceUp) {
+                        if (pos.faceDown[move.from] > 0) {
+                            out[count++] = move; // turns a card over
+                        } else if (pos.columnTop(move.to) != NO_CARD) {
+                            later[laterCount++] = move; // empties a column
+                        }
+                        // a whole column onto an empty column changes nothing
+                    } else {
+                        // Splitting a run is most useful when it frees a card for the foundation
+                        const CardId uncovered = pos.tableau[move.from][pos.columnSize[move.from] - move.count - 1];
+                        if (pos.foundationFor(uncovered) >= 0) {
+                            later[laterCount++] = move;
+                        } else {
+                            last[lastCount++] = move;
+                        }
+                    }
+                    break;
+                }
+                default:
+                    later[laterCount++] = move;
+                    break;
+            }
+        }
+
+        for (int i = 0; i < laterCount; i++) {
+            out[count++] = later[i];
+        }
+        for (int i = 0; i < lastCount; i++) {
+            out[count++] = last[i];
+        }
+        return count;
+    }
+
+private:
+    struct Frame {
+        MoveRecord applied;
+        uint8_t moveCount = 0;
+        uint8_t next = 0;
+        std::array<EngineMove, Rules::maxMoves> moves;
+    };
+
+    SolverOptions options;
+
+    // Looks up all children in one batch and keeps only unvisited ones,
+    // returns how many were dropped
+    int dropVisitedChildren(Position& pos, Frame& frame, SpillingMemo& memo) const {
+        std::array<uint64_t, Rules::maxMoves> keys;
+        std::array<bool, Rules::maxMoves> fresh;
+        for (int i = 0; i < frame.moveCount; i++) {
+            const MoveRecord record = applyMove<Rules>(pos, frame.moves[i]);
+            keys[i] = canonicalHash(pos, options.canonical);
+            undoMove<Rules>(pos, record);
+        }
+        memo.insertBatch(keys.data(), frame.moveCount, fresh.data());
+
+        int kept = 0;
+        for (int i = 0; i < frame.moveCount; i++) {
+            if (fresh[i]) frame.moves[kept++] = frame.moves[i];
+        }
+        const int dropped = frame.moveCount - kept;
+        frame.moveCount = static_cast<uint8_t>(kept);
+        return dropped;
+    }
+
+    // Fisher-Yates with xorshift32; a forced single move stays as it is
+    static void shuffleMoves(Frame& frame, uint32_t& state) {
+        for (int i = frame.moveCount - 1; i > 0; i--) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            std::swap(frame.moves[i], frame.moves[state % static_cast<uint32_t>(i + 1)]);
+        }
+    }
+
+    // Nothing can ever need to be placed on this card again: both cards it
+    // could hold (opposite colour, one rank lower) are already on foundations
+    static bool isSafeFoundationMove(const Position& pos, const CardId card) {
+        const int rank = rankValue(card);
+        if (rank <= 2) return true;
+
+        const bool red = isRedCard(card);
+        const int first = pos.foundationLevel(red ? Suit::Clubs : Suit::Hearts);
+        const int second = pos.foundationLevel(red ? Suit::Spades : Suit::Diamonds);
+        return first >= rank - 1 && second >= rank - 1;
+    }
+};
+
+#endif // SOLVER_H
@@ -0,0 +1,577 @@
+#ifndef SPILLINGMEMO_H
+#define SPILLINGMEMO_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Logger.h"
+
+// Bit array with k hash probes derived from one 64-bit key (double hashing)
+class BloomFilter {
+public:
+    BloomFilter() = default;
+
+    BloomFilter(const size_t keys, const int bitsPerKey) {
+        if (keys == 0 || bitsPerKey <= 0) return;
+        bitCount = std::max<size_t>(64, keys * static_cast<size_t>(bitsPerKey));
+        bits.assign((bitCount + 63) / 64, 0);
+        hashes = std::clamp(static_cast<int>(bitsPerKey * 0.69 + 0.5), 1, 8);
+    }
+
+    void add(const uint64_t key) {
+        if (bits.empty()) return;
+        uint64_t h = key;
+        const uint64_t step = (key >> 33) | 1;
+        for (int i = 0; i < hashes; i++, h += step) {
+            const size_t bit = h % bitCount;
+            bits[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+
+    // No bits at all means "no filter": everything may be present
+    bool mayContain(const uint64_t key) const {
+        if (bits.empty()) return true;
+        uint64_t h = key;
+        const uint64_t step = (key >> 33) | 1;
+        for (int i = 0; i < hashes; i++, h += step) {
+            const size_t bit = h % bitCount;
+            if (!(bits[bit / 64] & (uint64_t(1) << (bit % 64)))) return false;
+        }
+        return true;
+    }
+
+    size_t sizeBytes() const {
+        return bits.size() * sizeof(uint64_t);
+    }
+
+private:
+    std::vector<uint64_t> bits;
+    size_t bitCount = 0;
+    int hashes = 0;
+};
+
+// Visited-position set for searches that outgrow RAM.
+//
+// New keys go to an in-memory hash set. When it fills up its keys are sorted
+// and written out as an immutable run file. Each run keeps a bloom filter and
+// the first key of every block in memory, so a lookup touches the disk only
+// when the filter says maybe, and then reads a single block. Lookups come in
+// batches (all children of a search node) so several keys share a block read.
+// Once there are too many runs, a background thread merges them into one.
+//
+// options.memoBytes budgets the hash set, filters, fence keys and buffers;
+// the filters shrink (fewer bits per key) rather than go over it. Live runs
+// keep their filters and fences to half of the filter share. The other half
+// is for a merge, which builds the merged run's filter while its inputs
+// still hold theirs. The budget covers the memo only: the solver's arena and
+// the rest of the process come on top, so it does not cap the process RSS.
+class SpillingMemo {
+public:
+    struct Options {
+        size_t memoBytes = size_t(256) << 20; // the memo's own structures, not the process
+        std::filesystem::path directory;      // empty: a fresh folder in the system temp dir
+        int maxRuns = 8;                      // merge in the background beyond this
+        int bloomBitsPerKey = 10;
+    };
+
+    struct Stats {
+        size_t inserts = 0;      // keys that turned out new
+        size_t hotHits = 0;      // found in memory
+        size_t bloomRejects = 0; // ruled out by a filter
+        size_t diskProbes = 0;   // keys looked up in a run file
+        size_t diskHits = 0;
+        size_t blockReads = 0;
+        size_t spills = 0;
+        size_t merges = 0;
+        size_t keysOnDisk = 0;
+    };
+
+    SpillingMemo() : SpillingMemo(Options()) {}
+
+    explicit SpillingMemo(const Options& options) : options(options) {
+        directory = options.directory;
+        if (directory.empty()) {
+            std::random_device rd;
+            directory = std::filesystem::temp_directory_path() /
+                        ("solitaire-memo-" + std::to_string((static_cast<uint64_t>(rd()) << 32) | rd()));
+        }
+        std::filesystem::create_directories(directory);
+
+        const size_t slots = std::max<size_t>(1024, options.memoBytes * 3 / 10 / sizeof(uint64_t));
+        size_t capacity = 1024;
+        while (capacity * 2 <= slots) capacity *= 2;
+        hot.assign(capacity, EMPTY);
+        hotLimit = capacity / 10 * 7;
+
+        bloomShare = options.memoBytes * 3 / 5;
+        blockBuffer.resize(BLOCK_KEYS);
+    }
+
+    SpillingMemo(const SpillingMemo&) = delete;
+    SpillingMemo& operator=(const SpillingMemo&) = delete;
+
+    ~SpillingMemo() {
+        if (merger.joinable()) merger.join();
+        runs.clear();
+        std::error_code ignored;
+        std::filesystem::remove_all(directory, ignored);
+    }
+
+    // Drops every key, in memory and on disk
+    void clear() {
+        if (merger.joinable()) merger.join();
+        std::fill(hot.begin(), hot.end(), EMPTY);
+        hotUsed = 0;
+        std::lock_guard lock(runsMutex);
+        runs.clear();
+        stats.keysOnDisk = 0;
+    }
+
+    bool insert(const uint64_t key) {
+        bool fresh = false;
+        insertBatch(&key, 1, &fresh);
+        return fresh;
+    }
+
+    // fresh[i] is set for keys that were not present; those are added.
+    // A key repeated inside the batch counts as fresh only once.
+    void insertBatch(const uint64_t* keys, const int count, bool* fresh) {
+        // Memory first; what is left gets checked against the runs in key order
+        pending.clear();
+        for (int i = 0; i < count; i++) {
+            fresh[i] = false;
+            if (hotContains(normalize(keys[i]))) {
+                stats.hotHits++;
+            } else {
+                pending.push_back({normalize(keys[i]), i});
+            }
+        }
+
+        if (!pending.empty()) {
+            std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+                return a.key < b.key;
+            });
+
+            std::vector<std::shared_ptr<Run>> snapshot;
+            {
+                std::lock_guard lock(runsMutex);
+                snapshot = runs;
+            }
+            for (const auto& run : snapshot) {
+                probeRun(*run);
+            }
+        }
+
+        for (const Pending& item : pending) {
+            if (!item.found && hotInsert(item.key)) {
+                fresh[item.index] = true;
+                stats.inserts++;
+            }
+        }
+
+        if (hotUsed >= hotLimit) spill();
+    }
+
+    // Bytes held in memory by the memo itself
+    size_t memoryUsage() const {
+        size_t total = hot.size() * sizeof(uint64_t) + blockBuffer.size() * sizeof(uint64_t);
+        std::lock_guard lock(runsMutex);
+        for (const auto& run : runs) {
+            total += run->indexBytes();
+        }
+        return total + mergeBytes.load(std::memory_order_relaxed);
+    }
+
+    size_t runCount() const {
+        std::lock_guard lock(runsMutex);
+        return runs.size();
+    }
+
+    Stats getStats() const {
+        Stats copy = stats;
+        copy.merges = merges.load(std::memory_order_relaxed);
+        return copy;
+    }
+
+private:
+    static constexpr uint64_t EMPTY = 0;
+    static constexpr size_t BLOCK_KEYS = 512; // 4 KB per disk read
+
+    struct Run {
+        std::filesystem::path path;
+        std::FILE* file = nullptr;
+        size_t count = 0;
+        BloomFilter bloom;
+        std::vector<uint64_t> fences; // first key of each block
+
+        size_t indexBytes() const {
+            return bloom.sizeBytes() + fences.size() * sizeof(uint64_t);
+        }
+
+        ~Run() {
+            if (file) std::fclose(file);
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+        }
+    };
+
+    struct Pending {
+        uint64_t key;
+        int index;
+        bool found = false;
+    };
+
+    Options options;
+    std::filesystem::path directory;
+    Stats stats;
+
+    std::vector<uint64_t> hot; // open addressing, EMPTY marks a free slot
+    size_t hotUsed = 0;
+    size_t hotLimit = 0;
+
+    mutable std::mutex runsMutex;
+    std::vector<std::shared_ptr<Run>> runs; // oldest first
+    std::vector<std::shared_ptr<Run>> mergeInputs; // runs the merge in flight replaces
+    size_t mergeIndexBytes = 0;                    // filter and fences of the run it builds
+    size_t mergeKeys = 0;
+    std::thread merger;
+    std::atomic<bool> merging{false};
+    std::atomic<size_t> mergeBytes{0};
+    std::atomic<size_t> merges{0};
+    size_t bloomShare = 0;
+    size_t nextRunId = 0;
+
+    std::vector<Pending> pending;
+    std::vector<uint64_t> blockBuffer;
+
+    static void seekTo(std::FILE* file, const uint64_t offset) {
+#ifdef _WIN32
+        _fseeki64(file, static_cast<long long>(offset), SEEK_SET);
+#else
+        fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+    }
+
+    static uint64_t normalize(const uint64_t key) {
+        return key == EMPTY ? 1 : key;
+    }
+
+    bool hotContains(const uint64_t key) const {
+        const size_t mask = hot.size() - 1;
+        for (size_t i = key & mask;; i = (i + 1) & mask) {
+            if (hot[i] == key) return true;
+            if (hot[i] == EMPTY) return false;
+        }
+    }
+
+    bool hotInsert(const uint64_t key) {
+        const size_t mask = hot.size() - 1;
+        for (size_t i = key & mask;; i = (i + 1) & mask) {
+            if (hot[i] == key) return false;
+            if (hot[i] == EMPTY) {
+                hot[i] = key;
+                hotUsed++;
+                return true;
+            }
+        }
+    }
+
+    void probeRun(Run& run) {
+        size_t loadedBlock = SIZE_MAX;
+        size_t loadedCount = 0;
+
+        for (Pending& item : pending) {
+            if (item.found) continue;
+            if (!run.bloom.mayContain(item.key)) {
+                stats.bloomRejects++;
+                continue;
+            }
+
+            stats.diskProbes++;
+            const auto fence = std::upper_bound(run.fences.begin(), run.fences.end(), item.key);
+            if (fence == run.fences.begin()) continue;
+            const size_t block = static_cast<size_t>(fence - run.fences.begin()) - 1;
+
+            // Keys arrive sorted, so consecutive probes often share a block
+            if (block != loadedBlock) {
+                loadedCount = readBlock(run, block);
+                loadedBlock = block;
+                stats.blockReads++;
+            }
+
+            if (std::binary_search(blockBuffer.begin(), blockBuffer.begin() + static_cast<std::ptrdiff_t>(loadedCount), item.key)) {
+                item.found = true;
+                stats.diskHits++;
+            }
+        }
+    }
+
+    size_t readBlock(Run& run, const size_t block) {
+        const size_t first = block * BLOCK_KEYS;
+        const size_t count = std::min(BLOCK_KEYS, run.count - first);
+        seekTo(run.file, first * sizeof(uint64_t));
+        if (std::fread(blockBuffer.data(), sizeof(uint64_t), count, run.file) != count) {
+            Logger::error("Memo run read failed: ", run.path.string());
+            return 0;
+        }
+        return count;
+    }
+
+    static size_t fenceBytes(const size_t keys) {
+        return (keys + BLOCK_KEYS - 1) / BLOCK_KEYS * sizeof(uint64_t);
+    }
+
+    // Bloom bits per key for a new run. What counts is the set of runs live
+    // once the merge in flight is done: its inputs as already replaced by its
+    // output, so a merge sizing its own output gets the room its inputs free.
+    // Their filters and fences stay within half the filter share, and every
+    // run gets the bits per key that would also leave room for the spills
+    // still to come before the next merge.
+    int bloomBitsFor(const size_t keys) const {
+        if (keys == 0) return 0;
+        size_t used = fenceBytes(keys);
+        size_t liveKeys = keys;
+        {
+            std::lock_guard lock(runsMutex);
+            for (const auto& run : runs) {
+                if (std::find(mergeInputs.begin(), mergeInputs.end(), run) != mergeInputs.end()) continue;
+                used += run->indexBytes();
+                liveKeys += run->count;
+            }
+            used += mergeIndexBytes;
+            liveKeys += mergeKeys;
+        }
+        const size_t budget = bloomShare / 2;
+        const size_t available = budget > used ? budget - used : 0;
+        const size_t projectedKeys = liveKeys + static_cast<size_t>(options.maxRuns) * hotLimit;
+        return static_cast<int>(std::min({static_cast<size_t>(options.bloomBitsPerKey), budget * 8 / projectedKeys,
+                                          available * 8 / keys}));
+    }
+
+    std::filesystem::path nextRunPath() {
+        return directory / ("run-" + std::to_string(nextRunId++) + ".bin");
+    }
+
+    // Opens a finished run file and builds its in-memory index, null if the
+    // file can't be opened
+    static std::shared_ptr<Run> openRun(const std::filesystem::path& path, const size_t count, const int bloomBits,
+                                        const uint64_t* sortedKeys) {
+        auto run = std::make_shared<Run>();
+        run->path = path;
+        run->count = count;
+        run->file = std::fopen(path.string().c_str(), "rb");
+        if (!run->file) {
+            Logger::error("Memo run open failed: ", path.string());
+            return nullptr;
+        }
+        run->bloom = BloomFilter(count, bloomBits);
+        run->fences.reserve((count + BLOCK_KEYS - 1) / BLOCK_KEYS);
+        for (size_t i = 0; i < count; i++) {
+            run->bloom.add(sortedKeys[i]);
+            if (i % BLOCK_KEYS == 0) run->fences.push_back(sortedKeys[i]);
+        }
+        return run;
+    }
+
+    // Writes the hot set out as a run, sorted in place so no copy of it is
+    // needed. If that fails its keys are lost: the search may visit those
+    // positions again, but never skips one it has not seen.
+    void spill() {
+        const auto end = std::remove(hot.begin(), hot.end(), EMPTY);
+        std::sort(hot.begin(), end);
+        const auto count = static_cast<size_t>(end - hot.begin());
+
+        const std::filesystem::path path = nextRunPath();
+        std::FILE* out = std::fopen(path.string().c_str(), "wb");
+        const bool written = out && std::fwrite(hot.data(), sizeof(uint64_t), count, out) == count;
+        if ((out && std::fclose(out) != 0) || !written) {
+            Logger::error("Memo spill failed: ", path.string());
+        }
+
+        auto run = written ? openRun(path, count, bloomBitsFor(count), hot.data()) : nullptr;
+        std::fill(hot.begin(), hot.end(), EMPTY);
+        hotUsed = 0;
+        if (!run) {
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+            return;
+        }
+
+        {
+            std::lock_guard lock(runsMutex);
+            runs.push_back(std::move(run));
+        }
+        stats.spills++;
+        stats.keysOnDisk += count;
+
+        startMergeIfNeeded();
+    }
+
+    void startMergeIfNeeded() {
+        if (merging.load() || runCount() <= static_cast<size_t>(options.maxRuns)) return;
+        if (merger.joinable()) merger.join();
+
+        std::vector<std::shared_ptr<Run>> inputs;
+        {
+            std::lock_guard lock(runsMutex);
+            inputs = runs;
+            mergeInputs = runs;
+        }
+        merging.store(true);
+        merger = std::thread([this, inputs, path = nextRunPath()] {
+            mergeRuns(inputs, path);
+            merging.store(false);
+        });
+    }
+
+    // K-way merge of the inputs into one run, then swap it in under the lock.
+    // On a file error the merge is dropped and the inputs stay as they are.
+    void mergeRuns(const std::vector<std::shared_ptr<Run>>& inputs, const std::filesystem::path& path) {
+        struct Cursor {
+            std::FILE* file;
+            std::vector<uint64_t> buffer;
+            size_t remaining;
+            size_t position = 0;
+            size_t loaded = 0;
+
+            bool next(uint64_t& key) {
+                if (position == loaded) {
+                    if (remaining == 0) return false;
+                    loaded = std::fread(buffer.data(), sizeof(uint64_t), std::min(buffer.size(), remaining), file);
+                    if (loaded == 0) return false;
+                    remaining -= loaded;
+                    position = 0;
+                }
+                key = buffer[position++];
+                return true;
+            }
+        };
+
+        // Read and write buffers share what the hot set, the filters and the
+        // block buffer leave of the budget
+        const size_t fixedBytes = (hot.size() + blockBuffer.size()) * sizeof(uint64_t) + bloomShare;
+        const size_t bufferBytes = options.memoBytes > fixedBytes ? options.memoBytes - fixedBytes : 0;
+        const size_t mergeBufferKeys = std::clamp<size_t>(bufferBytes / sizeof(uint64_t) / (inputs.size() + 1), 64, 8192);
+        size_t total = 0;
+        std::vector<Cursor> cursors;
+        bool failed = false;
+        for (const auto& run : inputs) {
+            cursors.push_back({std::fopen(run->path.string().c_str(), "rb"),
+                               std::vector<uint64_t>(mergeBufferKeys), run->count});
+            failed |= !cursors.back().file;
+            total += run->count;
+        }
+        std::FILE* out = failed ? nullptr : std::fopen(path.string().c_str(), "wb");
+
+        const auto abandon = [&] {
+            Logger::error("Memo merge failed: ", path.string());
+            for (Cursor& cursor : cursors) {
+                if (cursor.file) std::fclose(cursor.file);
+            }
+            if (out) std::fclose(out);
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+            std::lock_guard lock(runsMutex);
+            mergeInputs.clear();
+            mergeIndexBytes = 0;
+            mergeKeys = 0;
+            mergeBytes.store(0);
+        };
+        if (!out) {
+            abandon();
+            return;
+        }
+
+        const int bloomBits = bloomBitsFor(total);
+        BloomFilter bloom(total, bloomBits);
+        std::vector<uint64_t> fences;
+        fences.reserve((total + BLOCK_KEYS - 1) / BLOCK_KEYS);
+        std::vector<uint64_t> output;
+        output.reserve(mergeBufferKeys);
+        {
+            std::lock_guard lock(runsMutex);
+            mergeIndexBytes = bloom.sizeBytes() + fenceBytes(total);
+            mergeKeys = total;
+        }
+        mergeBytes.store(bloom.sizeBytes() + fenceBytes(total) + (cursors.size() + 1) * mergeBufferKeys * sizeof(uint64_t));
+
+        std::vector<std::pair<uint64_t, size_t>> heads;
+        for (size_t i = 0; i < cursors.size(); i++) {
+            uint64_t key;
+            if (cursors[i].next(key)) heads.emplace_back(key, i);
+        }
+        std::make_heap(heads.begin(), heads.end(), std::greater<>());
+
+        size_t written = 0;
+        while (!heads.empty()) {
+            std::pop_heap(heads.begin(), heads.end(), std::greater<>());
+            auto [key, source] = heads.back();
+            heads.pop_back();
+
+            bloom.add(key);
+            if (written % BLOCK_KEYS == 0) fences.push_back(key);
+            output.push_back(key);
+            written++;
+            if (output.size() == mergeBufferKeys) {
+                if (std::fwrite(output.data(), sizeof(uint64_t), output.size(), out) != output.size()) {
+                    abandon();
+                    return;
+                }
+                output.clear();
+            }
+
+            uint64_t next;
+            if (cursors[source].next(next)) {
+                heads.emplace_back(next, source);
+                std::push_heap(heads.begin(), heads.end(), std::greater<>());
+            }
+        }
+        const bool flushed = std::fwrite(output.data(), sizeof(uint64_t), output.size(), out) == output.size();
+        const bool closed = std::fclose(out) == 0;
+        out = nullptr;
+        if (!flushed || !closed || written != total) {
+            abandon();
+            return;
+        }
+        for (Cursor& cursor : cursors) {
+            std::fclose(cursor.file);
+            cursor.file = nullptr;
+        }
+
+        auto merged = std::make_shared<Run>();
+        merged->path = path;
+        merged->count = written;
+        merged->file = std::fopen(path.string().c_str(), "rb");
+        if (!merged->file) {
+            merged->path.clear(); // abandon() removes the file
+            abandon();
+            return;
+        }
+        merged->bloom = std::move(bloom);
+        merged->fences = std::move(fences);
+
+        {
+            std::lock_guard lock(runsMutex);
+            std::erase_if(runs, [&](const std::shared_ptr<Run>& run) {
+                return std::find(inputs.begin(), inputs.end(), run) != inputs.end();
+            });
+            runs.insert(runs.begin(), std::move(merged));
+            mergeInputs.clear();
+            mergeIndexBytes = 0;
+            mergeKeys = 0;
+        }
+        mergeBytes.store(0);
+        merges++;
+    }
+};
+
+#endif // SPILLINGMEMO_H
@@ -0,0 +1,90 @@
+#ifndef STOCKPILE_H
+#define STOCKPILE_H
+
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+#include "Card.h"
+
+// Stock and waste share one array split by a cursor:
+//   cards[0, cursor)         - waste, top card at cursor - 1
+//   cards[cursor, size())    - stock, next card to draw at cursor
+// Drawing, recycling and undoing either of them only moves the cursor.
+// Face orientation is implied by the side of the cursor a card is on.
+class StockPile {
+public:
+    void reset() {
+        cards.clear();
+        cursor = 0;
+    }
+
+    void push(const Card& card) {
+        cards.push_back(card);
+    }
+
+    size_t stockSize() const {
+        return cards.size() - cursor;
+    }
+
+    size_t wasteSize() const {
+        return cursor;
+    }
+
+    bool stockEmpty() const {
+        return cursor == cards.size();
+    }
+
+    bool wasteEmpty() const {
+        return cursor == 0;
+    }
+
+    const Card& peekStock() const {
+        if (stockEmpty()) throw std::out_of_range("Stock is empty");
+        return cards[cursor];
+    }
+
+    const Card& peekWaste() const {
+        if (wasteEmpty()) throw std::out_of_range("Waste is empty");
+        return cards[cursor - 1];
+    }
+
+    // Moves up to numCards from stock to waste, returns how many were drawn
+    size_t draw(const size_t numCards) {
+        const size_t drawn = std::min(numCards, stockSize());
+        cursor += drawn;
+        return drawn;
+    }
+
+    // Turns the waste over so it becomes the stock again, order preserved
+    void recycle() {
+        cursor = 0;
+    }
+
+    size_t getCursor() const {
+        return cursor;
+    }
+
+    void setCursor(const size_t newCursor) {
+        cursor = std::min(newCursor, cards.size());
+    }
+
+    // Removes the top waste card (played to a foundation or tableau)
+    void popWaste() {
+        if (wasteEmpty()) return;
+        cards.erase(cards.begin() + static_cast<std::ptrdiff_t>(cursor - 1));
+        cursor--;
+    }
+
+    // Puts a card back on top of the waste (undo of popWaste)
+    void pushWaste(const Card& card) {
+        cards.insert(cards.begin() + static_cast<std::ptrdiff_t>(cursor), card);
+        cursor++;
+    }
+
+private:
+    std::vector<Card> cards;
+    size_t cursor = 0;
+};
+
+#endif // STOCKPILE_H
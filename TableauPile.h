@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <stdexcept>
+#include <cstdint>
 #include "Card.h"
 #include "ScreenBuffer.h"
 #include "Renderable.h"
@@ -12,26 +13,46 @@ public:
     TableauPile() : Renderable(7, 20), selected(false), selectedCard(0) {}
 
     void setSelected(const bool isSelected, const int index) {
+        if (isSelected == selected && (!selected || index == selectedCard)) return;
         selected = isSelected;
         selectedCard = index;
+        markDirty();
+    }
+
+    // Cards overlap by two rows, so a pile is taller than its nominal height
+    Rect bounds() const {
+        const int rows = cards.empty() ? 7 : static_cast<int>(cards.size() - 1) * 2 + 7;
+        return {posX, posY, width, rows};
     }
 
     int countFaceUp() const {
-        int count = 0;
-        for (const Card& card : cards) {
-            if (card.isFaceUp) {
-                count++;
-            }
-        }
-        return count;
+        return static_cast<int>(cards.size()) - faceDown;
+    }
+
+    int countFaceDown() const {
+        return faceDown;
     }
 
     void push(const Card& card) {
+        const size_t index = cards.size();
+        if (!card.isFaceUp) {
+            faceDown++;
+            runStart.push_back(static_cast<uint8_t>(index + 1)); // empty run
+        } else if (index > 0 && cards.back().isFaceUp && continuesRun(cards.back(), card)) {
+            runStart.push_back(runStart.back());
+        } else {
+            runStart.push_back(static_cast<uint8_t>(index));
+        }
         cards.push_back(card);
+        markDirty();
     }
 
     void pop() {
-        if (!cards.empty()) cards.pop_back();
+        if (cards.empty()) return;
+        if (!cards.back().isFaceUp) faceDown--;
+        cards.pop_back();
+        runStart.pop_back();
+        markDirty();
     }
 
     size_t size() const {
@@ -47,44 +68,67 @@ public:
         return cards[index];
     }
 
-    Card& get(const size_t index) {
-        if (index >= cards.size()) throw std::out_of_range("TableauPile index out of range");
-        return cards[index];
+    const Card& top() const {
+        if (cards.empty()) throw std::out_of_range("TableauPile is empty");
+        return cards.back();
     }
 
     void reset() {
         cards.clear();
+        runStart.clear();
+        faceDown = 0;
+        markDirty();
     }
 
     void flipTopCard() {
-        if (!cards.empty()) {
-            cards.back().isFaceUp = true;
-        }
+        if (cards.empty() || cards.back().isFaceUp) return;
+        cards.back().isFaceUp = true;
+        faceDown--;
+        const size_t index = cards.size() - 1;
+        runStart.back() = index > 0 && cards[index - 1].isFaceUp && continuesRun(cards[index - 1], cards.back())
+            ? runStart[index - 1]
+            : static_cast<uint8_t>(index);
+        markDirty();
     }
 
-    // Check if a sequence of cards from startIndex is valid (alternating colors, descending ranks)
-    bool isValidSequence(const size_t startIndex) const {
-        if (startIndex >= cards.size()) return false;
+    // Turns the top card face down again (undo of flipTopCard)
+    void unflipTopCard() {
+        if (cards.empty() || !cards.back().isFaceUp) return;
+        cards.back().isFaceUp = false;
+        faceDown++;
+        runStart.back() = static_cast<uint8_t>(cards.size());
+        markDirty();
+    }
 
-        for (size_t i = startIndex; i < cards.size() - 1; i++) {
-            const Card& current = cards[i];
-            const Card& next = cards[i + 1];
+    // Index of the first card of the valid run ending at the top card
+    size_t movableRunStart() const {
+        return cards.empty() ? 0 : runStart.back();
+    }
 
-            // Check if cards are face up
-            if (!current.isFaceUp || !next.isFaceUp) return false;
+    size_t movableRunLength() const {
+        return cards.size() - movableRunStart();
+    }
 
-            // Check opposite colors: Hearts and Diamonds are red, Clubs and Spades are black
-            const bool isCurrentRed = (current.suit == Suit::Hearts || current.suit == Suit::Diamonds);
-            const bool isNextRed = (next.suit == Suit::Hearts || next.suit == Suit::Diamonds);
-            const bool oppositeColors = isCurrentRed != isNextRed;
+    // Check if a sequence of cards from startIndex is valid (alternating colors, descending ranks)
+    bool isValidSequence(const size_t startIndex) const {
+        return startIndex < cards.size() && startIndex >= movableRunStart();
+    }
 
-            // Check descending ranks (lower rank goes on higher rank)
-            const bool correctRank = static_cast<int>(current.rank) + 1 == static_cast<int>(next.rank);
+    // Whether card (or a run starting with it) can be placed on top of this pile
+    bool canAccept(const Card& card) const {
+        if (cards.empty()) return card.rank == Rank::King; // Empty tableau pile must start with King
+        return cards.back().isFaceUp && continuesRun(cards.back(), card);
+    }
 
-            if (!oppositeColors || !correctRank) return false;
-        }
+    // Index of the card in the movable run that can go onto target, -1 if none.
+    // Ranks in a run drop by one per card, so the candidate is found by arithmetic.
+    int runIndexOnto(const Card& target) const {
+        return runIndexForRank(static_cast<int>(target.rank) - 1, &target);
+    }
 
-        return true;
+    // Index of a King heading the movable run (can go onto an empty pile), -1 if none
+    int kingRunIndex() const {
+        return runIndexForRank(static_cast<int>(Rank::King), nullptr);
     }
 
     void render(ScreenBuffer& screen) const {
@@ -112,9 +156,28 @@ public:
     }
 
 private:
+    // Invariant: face-down cards are always below the face-up ones
     std::vector<Card> cards;
+    std::vector<uint8_t> runStart; // per card: where the valid run ending at it begins
+    int faceDown = 0;
     bool selected;
     int selectedCard;
+
+    static bool continuesRun(const Card& below, const Card& above) {
+        return isRedSuit(below.suit) != isRedSuit(above.suit) &&
+               static_cast<int>(above.rank) + 1 == static_cast<int>(below.rank);
+    }
+
+    int runIndexForRank(const int rank, const Card* target) const {
+        if (cards.empty() || !cards.back().isFaceUp) return -1;
+
+        const int topIndex = static_cast<int>(cards.size()) - 1;
+        const int index = topIndex - (rank - static_cast<int>(cards.back().rank));
+        if (index < static_cast<int>(runStart.back()) || index > topIndex) return -1;
+        if (target && isRedSuit(target->suit) == isRedSuit(cards[index].suit)) return -1;
+
+        return index;
+    }
 };
 
 #endif // TABLEUPILE_H
\ No newline at end of file
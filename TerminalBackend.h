@@ -0,0 +1,187 @@
+#ifndef TERMINALBACKEND_H
+#define TERMINALBACKEND_H
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "AnsiEncoder.h"
+#include "ScreenBackend.h"
+
+// The POSIX terminal the game runs in, set up for the whole session: raw
+// input, the alternate screen with the cursor hidden, and signal handlers.
+// Everything is put back when it goes out of scope. One per process.
+//
+// Resizes are not polled: SIGWINCH bumps a counter, and a backend asks the
+// terminal for its size only after the counter moved. SIGINT, SIGTERM and
+// SIGHUP ask the main loop to end, so the terminal is always restored.
+//
+// Log lines written to std::cout while the game owns the screen are kept
+// and printed once it is handed back, as the console shows them after the
+// game's screen buffers go away.
+class Terminal {
+public:
+    Terminal() {
+        if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO) || tcgetattr(STDIN_FILENO, &saved) != 0) return;
+
+        termios raw = saved;
+        raw.c_iflag &= ~static_cast<tcflag_t>(ICRNL | IXON | BRKINT | ISTRIP | INPCK);
+        raw.c_oflag &= ~static_cast<tcflag_t>(OPOST);
+        raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | IEXTEN); // ISIG stays: Ctrl+C still ends the game
+        raw.c_cflag |= CS8;
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0) return;
+
+        struct sigaction action{};
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        action.sa_handler = [](int) { resizes.fetch_add(1, std::memory_order_relaxed); };
+        sigaction(SIGWINCH, &action, &savedWinch);
+        action.sa_handler = [](int) { closeRequested.store(true, std::memory_order_relaxed); };
+        for (size_t i = 0; i < std::size(CLOSING_SIGNALS); i++) {
+            sigaction(CLOSING_SIGNALS[i], &action, &savedClosing[i]);
+        }
+
+        logs = std::cout.rdbuf(heldLogs.rdbuf());
+        write("\x1b[?1049h\x1b[?25l\x1b[2J");
+        ok = true;
+    }
+
+    ~Terminal() {
+        if (!ok) return;
+
+        write("\x1b[0m\x1b[?25h\x1b[?1049l");
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+        sigaction(SIGWINCH, &savedWinch, nullptr);
+        for (size_t i = 0; i < std::size(CLOSING_SIGNALS); i++) {
+            sigaction(CLOSING_SIGNALS[i], &savedClosing[i], nullptr);
+        }
+
+        std::cout.rdbuf(logs);
+        std::cout << heldLogs.str() << std::flush;
+    }
+
+    Terminal(const Terminal&) = delete;
+    Terminal& operator=(const Terminal&) = delete;
+
+    // False if stdin and stdout are not a terminal
+    bool ready() const {
+        return ok;
+    }
+
+    // A signal asked the game to end
+    bool closing() const {
+        return closeRequested.load(std::memory_order_relaxed);
+    }
+
+    // SIGWINCHs received so far
+    uint32_t resizeCount() const {
+        return resizes.load(std::memory_order_relaxed);
+    }
+
+    bool size(short& width, short& height) const {
+        winsize window{};
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) != 0 || window.ws_col == 0 || window.ws_row == 0) return false;
+        width = static_cast<short>(window.ws_col);
+        height = static_cast<short>(window.ws_row);
+        return true;
+    }
+
+    // Writes all of it, however many write() calls that takes
+    void write(std::string_view bytes) const {
+        while (!bytes.empty()) {
+            const ssize_t written = ::write(STDOUT_FILENO, bytes.data(), bytes.size());
+            if (written < 0) {
+                if (errno == EINTR || errno == EAGAIN) continue;
+                return;
+            }
+            bytes.remove_prefix(static_cast<size_t>(written));
+        }
+    }
+
+private:
+    friend class TerminalBackend;
+
+    static constexpr int CLOSING_SIGNALS[] = {SIGINT, SIGTERM, SIGHUP};
+    static inline std::atomic<uint32_t> resizes{0};
+    static inline std::atomic<bool> closeRequested{false};
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "touched from signal handlers");
+
+    bool ok = false;
+    termios saved{};
+    struct sigaction savedWinch{};
+    struct sigaction savedClosing[std::size(CLOSING_SIGNALS)]{};
+    std::streambuf* logs = nullptr;
+    std::ostringstream heldLogs;
+
+    // Screens share the terminal; whichever was activated last is on it
+    std::mutex mutex;
+    const void* activeScreen = nullptr;
+};
+
+// One screen on a Terminal. Each keeps its last frame, so switching screens
+// with activate() repaints at once, the way a console switches buffers.
+class TerminalBackend : public ScreenBackend {
+public:
+    explicit TerminalBackend(Terminal& terminal) : terminal(terminal), seenResizes(terminal.resizeCount()) {}
+
+    void initialSize(short& width, short& height) override {
+        if (!terminal.size(width, height)) {
+            width = 80;
+            height = 24;
+        }
+    }
+
+    bool resized(short& width, short& height) override {
+        const uint32_t resizes = terminal.resizeCount();
+        if (resizes == seenResizes) return false;
+        seenResizes = resizes;
+        return terminal.size(width, height);
+    }
+
+    void activate() override {
+        std::lock_guard lock(terminal.mutex);
+        terminal.activeScreen = this;
+        encoder.reset(); // another screen drew over this one
+        if (!last.cells.empty()) show(last);
+    }
+
+    void present(const ConsoleFrame& frame) override {
+        std::lock_guard lock(terminal.mutex);
+        last.width = frame.width;
+        last.height = frame.height;
+        last.cells.assign(frame.cells.begin(), frame.cells.end());
+        if (terminal.activeScreen == this) show(last);
+    }
+
+    // Bytes written for the last frame this screen showed
+    size_t lastFrameBytes() const {
+        return encoder.lastFrameBytes();
+    }
+
+private:
+    Terminal& terminal;
+    uint32_t seenResizes;
+    ConsoleFrame last;
+    AnsiEncoder encoder;
+
+    void show(const ConsoleFrame& frame) {
+        const std::string& bytes = encoder.encode(frame);
+        if (!bytes.empty()) terminal.write(bytes);
+    }
+};
+
+#endif // TERMINALBACKEND_H
@@ -0,0 +1,111 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Position.h"
+#include "Rules.h"
+
+// Whole history of a game, for rewinding to any move.
+//
+// A keyframe of the full Position is taken every `interval` moves and the
+// moves in between are kept as 4-byte EngineMoves, so a game costs a few
+// bytes per move. Seeking restores the nearest keyframe at or before the
+// target and replays at most interval - 1 moves. Keyframes never change once
+// taken and are shared between copies, so a copy (e.g. a QA branch) costs
+// only its own move list and the keyframes it adds afterwards.
+class Timeline {
+public:
+    static constexpr size_t DEFAULT_INTERVAL = 32;
+
+    explicit Timeline(const size_t interval = DEFAULT_INTERVAL) : interval(interval ? interval : 1) {
+        reset(Position{}, RuleVariant::Draw1);
+    }
+
+    Timeline(const Position& start, const RuleVariant rules, const size_t interval = DEFAULT_INTERVAL)
+        : interval(interval ? interval : 1) {
+        reset(start, rules);
+    }
+
+    void reset(const Position& start, const RuleVariant rules) {
+        this->rules = rules;
+        moves.clear();
+        keyframes.clear();
+        keyframes.push_back(std::make_shared<const Position>(start));
+        current = start;
+    }
+
+    // Appends a move legal in the latest position
+    void push(const EngineMove& move) {
+        withRules(rules, [&](auto r) { applyMove<decltype(r)>(current, move); });
+        moves.push_back(move);
+        if (moves.size() % interval == 0) {
+            keyframes.push_back(std::make_shared<const Position>(current));
+        }
+    }
+
+    // Drops every move after the first `count`, e.g. to branch off after a rewind
+    void truncate(const size_t count) {
+        if (count >= moves.size()) return;
+        current = positionAt(count);
+        moves.resize(count);
+        keyframes.resize(count / interval + 1);
+    }
+
+    // Position after the first `index` moves
+    Position positionAt(const size_t index) const {
+        if (index > moves.size()) throw std::out_of_range("Timeline index out of range");
+
+        const size_t keyframe = index / interval;
+        Position pos = *keyframes[keyframe];
+        withRules(rules, [&](auto r) {
+            for (size_t i = keyframe * interval; i < index; i++) {
+                applyMove<decltype(r)>(pos, moves[i]);
+            }
+        });
+        return pos;
+    }
+
+    RuleVariant getRules() const {
+        return rules;
+    }
+
+    const Position& latest() const {
+        return current;
+    }
+
+    const EngineMove& moveAt(const size_t index) const {
+        return moves.at(index);
+    }
+
+    // Contiguous moves, for writing the timeline out in one go
+    const EngineMove* moveData() const {
+        return moves.data();
+    }
+
+    size_t size() const {
+        return moves.size();
+    }
+
+    size_t keyframeCount() const {
+        return keyframes.size();
+    }
+
+    // Bytes held for moves and keyframes, counting shared keyframes in full
+    size_t memoryUsage() const {
+        return moves.capacity() * sizeof(EngineMove) +
+               keyframes.capacity() * sizeof(std::shared_ptr<const Position>) +
+               keyframes.size() * sizeof(Position);
+    }
+
+private:
+    size_t interval;
+    RuleVariant rules = RuleVariant::Draw1;
+    std::vector<EngineMove> moves;
+    std::vector<std::shared_ptr<const Position>> keyframes; // keyframe k is the position after k * interval moves
+    Position current;
+};
+
+#endif // TIMELINE_H
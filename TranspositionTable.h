@@ -0,0 +1,136 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Fixed-size visited-position table shared by all search threads.
+//
+// Each 64-byte bucket holds four entries. An entry stores its data word and
+// key ^ data in two relaxed atomics; a reader accepts it only when the XOR
+// gives back the probed key, so a torn concurrent write reads as a miss and
+// no locks are needed. When a bucket is full the entry with the smallest
+// draft (least search work under it) is replaced, and entries left over from
+// an earlier search (older generation) are replaced before anything else.
+class TranspositionTable {
+public:
+    static constexpr size_t DEFAULT_BYTES = size_t(64) << 20;
+
+    explicit TranspositionTable(const size_t bytes = DEFAULT_BYTES) {
+        // Largest power-of-two bucket count that fits, so indexing is a mask
+        size_t count = 1;
+        while (count * 2 * sizeof(Bucket) <= bytes) count *= 2;
+
+        buckets = std::make_unique<Bucket[]>(count);
+        mask = count - 1;
+    }
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Starts a new search; entries from earlier ones stop counting as visited
+    void newSearch() {
+        generation = static_cast<uint16_t>(generation + 1);
+        if (generation == 0) generation = 1;
+    }
+
+    bool contains(const uint64_t key) const {
+        const Bucket& bucket = buckets[key & mask];
+        for (const Entry& entry : bucket.entries) {
+            const uint64_t data = entry.data.load(std::memory_order_relaxed);
+            const uint64_t check = entry.check.load(std::memory_order_relaxed);
+            if ((check ^ data) == key && isCurrent(data)) return true;
+        }
+        return false;
+    }
+
+    // Marks key as visited, returns false if it already was in this search.
+    // Two threads inserting the same key at once may both succeed; that only
+    // costs duplicated work.
+    bool insert(const uint64_t key, const uint8_t draft) {
+        Bucket& bucket = buckets[key & mask];
+        Entry* victim = nullptr;
+        int victimScore = INT32_MAX;
+
+        for (Entry& entry : bucket.entries) {
+            const uint64_t data = entry.data.load(std::memory_order_relaxed);
+            const uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+            if ((check ^ data) == key && isCurrent(data)) return false;
+
+            // Empty and stale entries go first, then the shallowest work
+            const int score = isCurrent(data) ? 256 + draftOf(data) : 0;
+            if (score < victimScore) {
+                victim = &entry;
+                victimScore = score;
+            }
+        }
+
+        const uint64_t data = USED_BIT | (static_cast<uint64_t>(draft) << 16) | generation;
+        victim->data.store(data, std::memory_order_relaxed);
+        victim->check.store(key ^ data, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Forgets everything; not safe while other threads use the table
+    void clear() {
+        for (size_t i = 0; i <= mask; i++) {
+            for (Entry& entry : buckets[i].entries) {
+                entry.data.store(0, std::memory_order_relaxed);
+                entry.check.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t capacity() const {
+        return (mask + 1) * ENTRIES_PER_BUCKET;
+    }
+
+    size_t sizeBytes() const {
+        return (mask + 1) * sizeof(Bucket);
+    }
+
+    // Share of sampled entries belonging to the current search, 0..1
+    double fillRatio(const size_t sampleBuckets = 4096) const {
+        const size_t samples = std::min(sampleBuckets, mask + 1);
+        size_t used = 0;
+        for (size_t i = 0; i < samples; i++) {
+            for (const Entry& entry : buckets[i].entries) {
+                if (isCurrent(entry.data.load(std::memory_order_relaxed))) used++;
+            }
+        }
+        return static_cast<double>(used) / static_cast<double>(samples * ENTRIES_PER_BUCKET);
+    }
+
+private:
+    static constexpr int ENTRIES_PER_BUCKET = 4;
+    static constexpr uint64_t USED_BIT = uint64_t(1) << 63;
+
+    // data word: bit 63 used, bits 16..23 draft, bits 0..15 generation
+    struct Entry {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[ENTRIES_PER_BUCKET];
+    };
+
+    static_assert(sizeof(Bucket) == 64);
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t mask = 0;
+    uint16_t generation = 1;
+
+    bool isCurrent(const uint64_t data) const {
+        return (data & USED_BIT) && static_cast<uint16_t>(data) == generation;
+    }
+
+    static int draftOf(const uint64_t data) {
+        return static_cast<int>((data >> 16) & 0xFF);
+    }
+};
+
+#endif // TRANSPOSITIONTABLE_H
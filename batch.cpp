@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "BeamSolver.h"
+#include "DeadDeal.h"
+#include "MoveNotation.h"
+#include "Position.h"
+#include "Rules.h"
+#include "Solver.h"
+
+// Headless batch front end for pipelines:
+//   SolitaireBatch [--rules draw1|draw3|draw3x3] [--threads N] [--node-limit N] [--simulate N]
+//                  [--beam WIDTH] [--time-budget MILLIS] [--memory-cap MEGABYTES]
+//
+// Reads one job per line from stdin and writes one JSON object per line to
+// stdout, in input order:
+//   <seed>              solve the deal, or play N random games with --simulate
+//   <seed> <move>...    replay the moves (MoveNotation.h) and validate them
+// Blank lines and lines starting with # produce no output.
+//
+// --beam solves with BeamSolver instead of the exhaustive Solver: each deal
+// gets an answer within the time budget and memory cap, but a lost deal is
+// rarely proved lost.
+
+namespace {
+    struct BatchOptions {
+        RuleVariant rules = RuleVariant::Draw1;
+        int threads = 1;
+        size_t nodeLimit = 200'000;
+        int simulations = 0;
+        BeamOptions beam;
+        bool useBeam = false;
+    };
+
+    // Runs a job on every input line with several worker threads and writes
+    // the results in input order. Lines in flight sit in a fixed ring of
+    // slots: the reader waits for a free slot and the writer for the oldest
+    // result, so memory stays bounded however long the input is.
+    class OrderedPipeline {
+    public:
+        using Job = std::function<std::string(const std::string& line, size_t lineNumber)>;
+
+        OrderedPipeline(const int threads, Job job, std::FILE* out)
+            : threads(std::max(1, threads)), job(std::move(job)), out(out), ring(static_cast<size_t>(this->threads) * 4) {}
+
+        void run(std::istream& in) {
+            std::vector<std::thread> workers;
+            for (int i = 0; i < threads; i++) {
+                workers.emplace_back([this] { work(); });
+            }
+            std::thread writer([this] { write(); });
+
+            std::string line;
+            while (std::getline(in, line)) {
+                std::unique_lock lock(mutex);
+                slotFree.wait(lock, [this] { return read - written < ring.size(); });
+                Slot& slot = ring[read % ring.size()];
+                slot.input = std::move(line);
+                slot.done = false;
+                read++;
+                lock.unlock();
+                jobReady.notify_one();
+            }
+
+            {
+                std::lock_guard lock(mutex);
+                finished = true;
+            }
+            jobReady.notify_all();
+            resultReady.notify_all();
+
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+            writer.join();
+            std::fflush(out);
+        }
+
+    private:
+        struct Slot {
+            std::string input;
+            std::string output;
+            bool done = false;
+        };
+
+        int threads;
+        Job job;
+        std::FILE* out;
+        std::vector<Slot> ring;
+
+        std::mutex mutex;
+        std::condition_variable jobReady;
+        std::condition_variable resultReady;
+        std::condition_variable slotFree;
+        size_t read = 0;    // lines placed in the ring
+        size_t next = 0;    // lines handed to a worker
+        size_t written = 0; // lines written out
+        bool finished = false;
+
+        void work() {
+            while (true) {
+                std::unique_lock lock(mutex);
+                jobReady.wait(lock, [this] { return next < read || finished; });
+                if (next == read) return; // finished and drained
+
+                const size_t index = next++;
+                Slot& slot = ring[index % ring.size()];
+                lock.unlock();
+
+                // The slot is ours until it is marked done
+                std::string result = job(slot.input, index + 1);
+
+                lock.lock();
+                slot.output = std::move(result);
+                slot.done = true;
+                if (index == written) {
+                    lock.unlock();
+                    resultReady.notify_one();
+                }
+            }
+        }
+
+        void write() {
+            while (true) {
+                std::unique_lock lock(mutex);
+                resultReady.wait(lock, [this] {
+                    return ring[written % ring.size()].done || (finished && written == read);
+                });
+                if (!ring[written % ring.size()].done) return;
+
+                std::string output = std::move(ring[written % ring.size()].output);
+                lock.unlock();
+
+                // Buffered by stdio, flushed only when the buffer fills or at the end
+                if (!output.empty()) {
+                    output += '\n';
+                    std::fwrite(output.data(), 1, output.size(), out);
+                }
+
+                lock.lock();
+                ring[written % ring.size()].done = false;
+                written++;
+                const bool nextDone = ring[written % ring.size()].done && written < read;
+                lock.unlock();
+                slotFree.notify_one();
+                if (nextDone) resultReady.notify_one();
+            }
+        }
+    };
+
+    // Input echoed back may contain anything
+    std::string jsonEscape(const std::string_view text) {
+        std::string escaped;
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                escaped += '?';
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    std::string dealJson(const Position& pos) {
+        std::string json = "{\"tableau\":[";
+        for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+            if (col) json += ',';
+            json += '"';
+            for (int i = 0; i < pos.columnSize[col]; i++) {
+                if (i) json += ' ';
+                json += cardToString(pos.tableau[col][i]);
+            }
+            json += '"';
+        }
+        json += "],\"stock\":\"";
+        for (int i = 0; i < pos.stockSize; i++) {
+            if (i) json += ' ';
+            json += cardToString(pos.stock[i]);
+        }
+        return json + "\"}";
+    }
+
+    const char* verdictName(const SolveResult result) {
+        switch (result) {
+            case SolveResult::Solved:     return "solved";
+            case SolveResult::Unsolvable: return "unsolvable";
+            case SolveResult::Unknown:    return "unknown";
+        }
+        return "?";
+    }
+
+    // Deals the dead-deal filter rejects are reported lost without a search
+    template <typename Rules>
+    std::string solveJson(const Position& deal, const BatchOptions& options) {
+        if (const DeadDeal dead = findDeadDeal<Rules>(deal); dead != DeadDeal::None) {
+            return std::string("\"verdict\":\"unsolvable\",\"nodes\":0,\"dead\":\"") + deadDealName(dead) + "\"";
+        }
+
+        const SolverOutcome outcome = options.useBeam ? BeamSolver<Rules>(options.beam).solve(deal)
+                                                      : Solver<Rules>({options.nodeLimit}).solve(deal);
+
+        std::string json = "\"verdict\":\"";
+        json += verdictName(outcome.result);
+        json += "\",\"nodes\":" + std::to_string(outcome.stats.nodes);
+        if (outcome.result == SolveResult::Solved) {
+            json += ",\"moves\":" + std::to_string(outcome.solution.size()) + ",\"solution\":\"";
+            for (size_t i = 0; i < outcome.solution.size(); i++) {
+                if (i) json += ' ';
+                json += moveToString(outcome.solution[i]);
+            }
+            json += '"';
+        }
+        return json;
+    }
+
+    template <typename Rules>
+    std::string replayJson(Position pos, std::istringstream& moves) {
+        size_t applied = 0;
+        std::string token;
+        while (moves >> token) {
+            EngineMove move;
+            const char* error = nullptr;
+            if (!parseMove(token, move)) {
+                error = "unreadable move";
+            } else if (!isLegalMove<Rules>(pos, move)) {
+                error = "illegal move";
+            }
+
+            if (error) {
+                return "\"replay\":{\"valid\":false,\"applied\":" + std::to_string(applied) +
+                       ",\"error\":\"" + error + "\",\"move\":\"" + jsonEscape(token.substr(0, 16)) + "\"}";
+            }
+            applyMove<Rules>(pos, move);
+            applied++;
+        }
+
+        return "\"replay\":{\"valid\":true,\"applied\":" + std::to_string(applied) +
+               ",\"win\":" + (pos.isWin() ? "true" : "false") +
+               ",\"foundation\":" + std::to_string(pos.cardsOnFoundations()) + "}";
+    }
+
+    // Random playouts: a foundation move when there is one, otherwise any
+    // legal move, until the game is won, stuck or out of moves
+    template <typename Rules>
+    std::string simulateJson(const Position& deal, const uint64_t seed, const int games) {
+        constexpr int maxMoves = 1000;
+        std::mt19937_64 rng(seed ^ 0x9e3779b97f4a7c15ULL);
+
+        int wins = 0;
+        size_t foundation = 0, moveTotal = 0;
+        std::array<EngineMove, Rules::maxMoves> legal;
+
+        for (int game = 0; game < games; game++) {
+            Position pos = deal;
+            int played = 0;
+            while (played < maxMoves && !pos.isWin()) {
+                const int count = generateMoves<Rules>(pos, legal.data());
+                if (count == 0) break;
+
+                const bool toFoundation = legal[0].type == EngineMove::Type::WasteToFoundation ||
+                                          legal[0].type == EngineMove::Type::TableauToFoundation;
+                applyMove<Rules>(pos, toFoundation ? legal[0] : legal[rng() % static_cast<uint64_t>(count)]);
+                played++;
+            }
+            if (pos.isWin()) wins++;
+            foundation += pos.cardsOnFoundations();
+            moveTotal += played;
+        }
+
+        char averages[64];
+        std::snprintf(averages, sizeof(averages), "\"avgFoundation\":%.2f,\"avgMoves\":%.1f",
+                      static_cast<double>(foundation) / games, static_cast<double>(moveTotal) / games);
+        return "\"simulation\":{\"games\":" + std::to_string(games) + ",\"wins\":" + std::to_string(wins) + "," +
+               averages + "}";
+    }
+
+    template <typename Rules>
+    std::string processLine(const std::string& line, const size_t lineNumber, const BatchOptions& options) {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') return {};
+
+        std::istringstream in(line);
+        uint64_t seed = 0;
+        std::string prefix = "{\"line\":" + std::to_string(lineNumber);
+        if (!(in >> seed)) {
+            return prefix + ",\"error\":\"expected a seed\"}";
+        }
+
+        const Position deal = dealPosition(seed);
+        prefix += ",\"seed\":" + std::to_string(seed) + ",\"rules\":\"" + rulesName(options.rules) + "\",\"deal\":" +
+                  dealJson(deal) + ",";
+
+        if (in >> std::ws && in.peek() != std::char_traits<char>::eof()) {
+            return prefix + replayJson<Rules>(deal, in) + "}";
+        }
+        if (options.simulations > 0) {
+            return prefix + simulateJson<Rules>(deal, seed, options.simulations) + "}";
+        }
+        return prefix + solveJson<Rules>(deal, options) + "}";
+    }
+
+    int usage() {
+        std::cerr << "usage: SolitaireBatch [--rules draw1|draw3|draw3x3] [--threads N] [--node-limit N] [--simulate N]\n"
+                     "                      [--beam WIDTH] [--time-budget MILLIS] [--memory-cap MEGABYTES]\n"
+                     "  stdin, one job per line: <seed> to solve (or simulate), <seed> <move>... to replay\n";
+        return 1;
+    }
+}
+
+int main(const int argc, char** argv) {
+    BatchOptions options;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) return usage();
+        const char* value = argv[++i];
+
+        if (arg == "--rules") {
+            if (!parseRules(value, options.rules)) return usage();
+        } else if (arg == "--threads") {
+            options.threads = std::max(1, std::atoi(value));
+        } else if (arg == "--node-limit") {
+            options.nodeLimit = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--simulate") {
+            options.simulations = std::max(0, std::atoi(value));
+        } else if (arg == "--beam") {
+            options.beam.width = static_cast<size_t>(std::max(1, std::atoi(value)));
+            options.useBeam = true;
+        } else if (arg == "--time-budget") {
+            options.beam.timeBudget = std::chrono::milliseconds(std::max(1, std::atoi(value)));
+        } else if (arg == "--memory-cap") {
+            options.beam.memoryCap = std::strtoull(value, nullptr, 10) << 20;
+        } else {
+            return usage();
+        }
+    }
+
+    std::ios::sync_with_stdio(false);
+    static char outputBuffer[1 << 20];
+    std::setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+    withRules(options.rules, [&](auto rules) {
+        using Rules = decltype(rules);
+        OrderedPipeline pipeline(options.threads, [&options](const std::string& line, const size_t lineNumber) {
+            return processLine<Rules>(line, lineNumber, options);
+        }, stdout);
+        pipeline.run(std::cin);
+    });
+    return 0;
+}
@@ -0,0 +1,1025 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "BeamSolver.h"
+#include "Canonical.h"
+#include "DeadDeal.h"
+#include "Evaluator.h"
+#include "MoveCache.h"
+#include "ParallelSolver.h"
+#include "RenderThread.h"
+#include "Rules.h"
+#include "ScoreVerifier.h"
+#include "Solver.h"
+#include "SpillingMemo.h"
+#include "Timeline.h"
+#include "TranspositionTable.h"
+
+// Offline benchmarks for the headless engine:
+//   SolitaireBench canonical [seeds] [draw] [nodeLimit]
+//   SolitaireBench arena [seeds] [draw] [nodeLimit]
+//   SolitaireBench tt [seeds] [draw] [megabytes] [threads...]
+//   SolitaireBench memo [seeds] [draw] [memoMegabytes] [nodeLimit]
+//   SolitaireBench timeline [moves] [interval]
+//   SolitaireBench verify [submissions] [threads...]
+//   SolitaireBench present [writeMicros] [keyMicros] [seconds]
+//   SolitaireBench bitboards [positions]
+//   SolitaireBench eval [positions] [passes] [weightsFile]
+//   SolitaireBench movecache [games] [steps] [draw]
+//   SolitaireBench dead [deals] [solved] [draw] [nodeLimit]
+//   SolitaireBench beam [seeds] [draw] [width] [budgetMillis] [capMegabytes] [nodeLimit]
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(const Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    size_t peakRssBytes() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+
+    const char* canonicalName(const Canonicalization level) {
+        switch (level) {
+            case Canonicalization::None:            return "none";
+            case Canonicalization::Columns:         return "columns";
+            case Canonicalization::ColumnsAndSuits: return "columns+suits";
+        }
+        return "?";
+    }
+
+    // Explored nodes per canonicalization level on seeds 1..seeds. Totals are
+    // dominated by deals that hit the node limit, so nodes are also summed over
+    // the seeds every level decided.
+    template <typename Rules>
+    int benchCanonical(const int seeds, const size_t nodeLimit) {
+        constexpr Canonicalization levels[] = {
+            Canonicalization::None, Canonicalization::Columns, Canonicalization::ColumnsAndSuits
+        };
+        constexpr int levelCount = static_cast<int>(std::size(levels));
+
+        std::vector<std::vector<SolverOutcome>> outcomes(levelCount);
+        std::vector<double> elapsed(levelCount);
+
+        for (int l = 0; l < levelCount; l++) {
+            const Solver<Rules> solver({nodeLimit, levels[l]});
+            const auto start = Clock::now();
+            for (int seed = 1; seed <= seeds; seed++) {
+                outcomes[l].push_back(solver.solve(dealPosition(seed)));
+            }
+            elapsed[l] = secondsSince(start);
+        }
+
+        std::vector<bool> decidedByAll(seeds, true);
+        for (int l = 0; l < levelCount; l++) {
+            for (int i = 0; i < seeds; i++) {
+                if (outcomes[l][i].result == SolveResult::Unknown) decidedByAll[i] = false;
+            }
+        }
+
+        std::cout << "seeds 1.." << seeds << ", draw " << Rules::drawCount << ", node limit " << nodeLimit << ", "
+                  << std::count(decidedByAll.begin(), decidedByAll.end(), true) << " seeds decided by every level\n";
+        std::cout << std::left << std::setw(16) << "canonical"
+                  << std::right << std::setw(12) << "nodes"
+                  << std::setw(14) << "decided nodes"
+                  << std::setw(12) << "transpos."
+                  << std::setw(8) << "solved"
+                  << std::setw(8) << "unsolv."
+                  << std::setw(8) << "unknown"
+                  << std::setw(9) << "seconds"
+                  << std::setw(10) << "vs none" << "\n";
+
+        size_t baseline = 0;
+        for (int l = 0; l < levelCount; l++) {
+            size_t nodes = 0, decidedNodes = 0, transpositions = 0;
+            int solved = 0, unsolvable = 0, unknown = 0;
+
+            for (int i = 0; i < seeds; i++) {
+                const SolverOutcome& outcome = outcomes[l][i];
+                nodes += outcome.stats.nodes;
+                transpositions += outcome.stats.transpositions;
+                if (decidedByAll[i]) decidedNodes += outcome.stats.nodes;
+                switch (outcome.result) {
+                    case SolveResult::Solved:     solved++; break;
+                    case SolveResult::Unsolvable: unsolvable++; break;
+                    case SolveResult::Unknown:    unknown++; break;
+                }
+            }
+            if (l == 0) baseline = decidedNodes;
+
+            std::cout << std::left << std::setw(16) << canonicalName(levels[l])
+                      << std::right << std::setw(12) << nodes
+                      << std::setw(14) << decidedNodes
+                      << std::setw(12) << transpositions
+                      << std::setw(8) << solved
+                      << std::setw(8) << unsolvable
+                      << std::setw(8) << unknown
+                      << std::setw(9) << std::fixed << std::setprecision(2) << elapsed[l]
+                      << std::setw(9) << std::setprecision(1)
+                      << (baseline ? 100.0 * static_cast<double>(decidedNodes) / static_cast<double>(baseline) : 0.0)
+                      << "%\n";
+        }
+        return 0;
+    }
+
+    // Chunk requests (malloc calls) the thread's arena makes per search on
+    // seeds 1..seeds. The arena keeps its chunks between searches, so only a
+    // search that needs more memory than every one before it should ask for any.
+    template <typename Rules>
+    int benchArena(const int seeds, const size_t nodeLimit) {
+        MonotonicArena& arena = MonotonicArena::forThread();
+        const Solver<Rules> solver({nodeLimit});
+
+        std::cout << "seeds 1.." << seeds << ", draw " << Rules::drawCount << ", node limit " << nodeLimit << "\n";
+        std::cout << std::setw(6) << "seed"
+                  << std::setw(12) << "nodes"
+                  << std::setw(14) << "allocations"
+                  << std::setw(10) << "chunks"
+                  << std::setw(12) << "arena MB" << "\n";
+
+        size_t allocations = 0, chunks = 0, growingSearches = 0;
+        for (int seed = 1; seed <= seeds; seed++) {
+            const ArenaStats before = arena.getStats();
+            const SolverOutcome outcome = solver.solve(dealPosition(seed));
+            const ArenaStats& after = arena.getStats();
+
+            const size_t searchAllocations = after.allocations - before.allocations;
+            const size_t searchChunks = after.upstreamAllocations - before.upstreamAllocations;
+            allocations += searchAllocations;
+            chunks += searchChunks;
+            if (searchChunks == 0) continue;
+
+            growingSearches++;
+            std::cout << std::setw(6) << seed
+                      << std::setw(12) << outcome.stats.nodes
+                      << std::setw(14) << searchAllocations
+                      << std::setw(10) << searchChunks
+                      << std::setw(12) << std::fixed << std::setprecision(1)
+                      << static_cast<double>(arena.capacity()) / (1 << 20) << "\n";
+        }
+
+        std::cout << seeds << " searches, " << allocations / static_cast<size_t>(std::max(1, seeds))
+                  << " arena allocations per search, " << chunks << " chunk requests in " << growingSearches
+                  << " searches (listed above), " << std::setprecision(2)
+                  << static_cast<double>(chunks) / std::max(1, seeds) << " per search\n";
+        return 0;
+    }
+
+    // Node throughput of ParallelSolver sharing one table, per thread count
+    template <typename Rules>
+    int benchTranspositionTable(const int seeds, const size_t megabytes,
+                                const std::vector<int>& threadCounts) {
+        TranspositionTable table(megabytes << 20);
+        std::cout << "seeds 1.." << seeds << ", draw " << Rules::drawCount << ", table " << (table.sizeBytes() >> 20)
+                  << " MB (" << table.capacity() << " entries), " << std::thread::hardware_concurrency()
+                  << " hardware threads\n";
+        std::cout << std::setw(8) << "threads"
+                  << std::setw(14) << "nodes"
+                  << std::setw(10) << "seconds"
+                  << std::setw(14) << "nodes/s"
+                  << std::setw(8) << "solved"
+                  << std::setw(8) << "unsolv."
+                  << std::setw(8) << "unknown" << "\n";
+
+        for (const int threads : threadCounts) {
+            ParallelSolver<Rules> solver(table, {2'000'000, Canonicalization::Columns}, threads);
+            size_t nodes = 0;
+            int solved = 0, unsolvable = 0, unknown = 0;
+
+            const auto start = Clock::now();
+            for (int seed = 1; seed <= seeds; seed++) {
+                const SolverOutcome outcome = solver.solve(dealPosition(seed));
+                nodes += outcome.stats.nodes;
+                switch (outcome.result) {
+                    case SolveResult::Solved:     solved++; break;
+                    case SolveResult::Unsolvable: unsolvable++; break;
+                    case SolveResult::Unknown:    unknown++; break;
+                }
+            }
+            const double elapsed = secondsSince(start);
+
+            std::cout << std::setw(8) << threads
+                      << std::setw(14) << nodes
+                      << std::setw(10) << std::fixed << std::setprecision(2) << elapsed
+                      << std::setw(14) << std::setprecision(0) << static_cast<double>(nodes) / elapsed
+                      << std::setw(8) << solved
+                      << std::setw(8) << unsolvable
+                      << std::setw(8) << unknown << "\n";
+        }
+
+        // Threads beyond the hardware ones only take turns, so their rows say
+        // nothing about scaling
+        const int most = *std::max_element(threadCounts.begin(), threadCounts.end());
+        const auto cores = static_cast<int>(std::thread::hardware_concurrency());
+        if (most > cores) {
+            std::cout << "note: " << most << " threads on " << cores << " hardware threads; rows above " << cores
+                      << " are oversubscribed and do not measure scaling\n";
+        }
+        return 0;
+    }
+
+    // Solves with the disk-spilling memo under a memo budget. The budget does
+    // not cover the solver's arena or the process, so RSS is reported too
+    template <typename Rules>
+    int benchMemo(const int seeds, const size_t memoMegabytes, const size_t nodeLimit) {
+        SpillingMemo::Options memoOptions;
+        memoOptions.memoBytes = memoMegabytes << 20;
+        SpillingMemo memo(memoOptions);
+
+        SolverOptions options{nodeLimit, Canonicalization::Columns};
+        options.memo = &memo;
+        const Solver<Rules> solver(options);
+
+        std::cout << "seeds 1.." << seeds << ", draw " << Rules::drawCount << ", memo budget " << memoMegabytes
+                  << " MB, node limit " << nodeLimit << "\n";
+        std::cout << std::setw(6) << "seed"
+                  << std::setw(12) << "result"
+                  << std::setw(12) << "nodes"
+                  << std::setw(10) << "seconds"
+                  << std::setw(8) << "spills"
+                  << std::setw(8) << "merges"
+                  << std::setw(12) << "disk keys"
+                  << std::setw(12) << "disk probes"
+                  << std::setw(12) << "block reads"
+                  << std::setw(10) << "memo MB"
+                  << std::setw(10) << "RSS MB" << "\n";
+
+        size_t peakMemo = 0;
+        for (int seed = 1; seed <= seeds; seed++) {
+            memo.clear();
+            const size_t before = memo.getStats().diskProbes;
+            const size_t readsBefore = memo.getStats().blockReads;
+
+            const auto start = Clock::now();
+            const SolverOutcome outcome = solver.solve(dealPosition(seed));
+            const double elapsed = secondsSince(start);
+
+            const SpillingMemo::Stats stats = memo.getStats();
+            peakMemo = std::max(peakMemo, memo.memoryUsage());
+            const char* result = outcome.result == SolveResult::Solved ? "solved"
+                               : outcome.result == SolveResult::Unsolvable ? "unsolvable" : "unknown";
+
+            std::cout << std::setw(6) << seed
+                      << std::setw(12) << result
+                      << std::setw(12) << outcome.stats.nodes
+                      << std::setw(10) << std::fixed << std::setprecision(2) << elapsed
+                      << std::setw(8) << stats.spills
+                      << std::setw(8) << stats.merges
+                      << std::setw(12) << stats.keysOnDisk
+                      << std::setw(12) << stats.diskProbes - before
+                      << std::setw(12) << stats.blockReads - readsBefore
+                      << std::setw(10) << std::setprecision(1) << static_cast<double>(memo.memoryUsage()) / (1 << 20)
+                      << std::setw(10) << static_cast<double>(peakRssBytes()) / (1 << 20) << "\n";
+        }
+
+        std::cout << "peak memo " << static_cast<double>(peakMemo) / (1 << 20) << " MB, peak RSS "
+                  << static_cast<double>(peakRssBytes()) / (1 << 20) << " MB (not capped), memo budget " << memoMegabytes << " MB\n";
+        return 0;
+    }
+
+    // Memory per move and seek cost of a Timeline over a long random game
+    int benchTimeline(const size_t moveCount, const size_t interval) {
+        std::mt19937 rng(1);
+        Timeline timeline(dealPosition(1), RuleVariant::Draw3, interval);
+        std::array<EngineMove, Draw3Rules::maxMoves> legal;
+        while (timeline.size() < moveCount) {
+            const int count = generateMoves<Draw3Rules>(timeline.latest(), legal.data());
+            if (count == 0) break;
+            timeline.push(legal[rng() % count]);
+        }
+
+        constexpr int seeks = 100000;
+        std::uniform_int_distribution<size_t> index(0, timeline.size());
+        size_t checksum = 0;
+        const auto start = Clock::now();
+        for (int i = 0; i < seeks; i++) {
+            checksum += timeline.positionAt(index(rng)).cursor;
+        }
+        const double elapsed = secondsSince(start);
+
+        std::cout << "moves " << timeline.size() << ", interval " << interval << ", keyframes "
+                  << timeline.keyframeCount() << "\n"
+                  << "memory " << timeline.memoryUsage() << " bytes, "
+                  << std::fixed << std::setprecision(2)
+                  << static_cast<double>(timeline.memoryUsage()) / static_cast<double>(timeline.size())
+                  << " bytes/move (Position is " << sizeof(Position) << " bytes)\n"
+                  << "seek " << std::setprecision(3) << elapsed / seeks * 1e6 << " us average"
+                  << " (checksum " << checksum << ")\n";
+        return 0;
+    }
+
+    // The rule checks as they were before Position kept card masks: a loop
+    // over the foundation tops or the column tops
+    bool loopIsWin(const Position& pos) {
+        for (const CardId top : pos.foundation) {
+            if (top == NO_CARD || rankValue(top) != 13) return false;
+        }
+        return true;
+    }
+
+    bool loopBuildsOnFoundation(const Position& pos, const CardId card) {
+        for (const CardId top : pos.foundation) {
+            if (buildsOn(card, top)) return true;
+        }
+        return false;
+    }
+
+    bool loopStacksOnTop(const Position& pos, const CardId card) {
+        for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+            const CardId top = pos.columnTop(col);
+            if (top != NO_CARD && stacksOn(card, top)) return true;
+        }
+        return false;
+    }
+
+    // Every position of random draw-1 games, up to 200 moves each
+    std::vector<Position> randomPositions(const size_t positionCount) {
+        std::mt19937_64 rng(1);
+        std::vector<Position> positions;
+        positions.reserve(positionCount);
+        while (positions.size() < positionCount) {
+            Position pos = dealPosition(rng());
+            for (int played = 0; played < 200 && positions.size() < positionCount; played++) {
+                EngineMove legal[MAX_MOVES];
+                const int count = generateMoves<Draw1Rules>(pos, legal);
+                if (count == 0) break;
+                applyMove<Draw1Rules>(pos, legal[rng() % static_cast<size_t>(count)]);
+                positions.push_back(pos);
+            }
+        }
+        return positions;
+    }
+
+    // Win test, foundation and tableau legality for every card, with loops
+    // and with the masks, over positions from random games
+    int benchBitboards(const size_t positionCount) {
+        const std::vector<Position> positions = randomPositions(positionCount);
+
+        // Each check's answers are folded into a checksum, so both ways must agree
+        const auto timed = [&positions](const auto& check, uint64_t& checksum) {
+            const auto start = Clock::now();
+            checksum = 0;
+            for (const Position& pos : positions) checksum = checksum * 31 + check(pos);
+            return secondsSince(start) / static_cast<double>(positions.size()) * 1e9;
+        };
+
+        struct Row {
+            const char* name;
+            double loopNanos;
+            double maskNanos;
+            bool agree;
+        };
+        std::vector<Row> rows;
+        const auto compare = [&](const char* name, const auto& loop, const auto& mask) {
+            uint64_t loopSum = 0, maskSum = 0;
+            const double loopNanos = timed(loop, loopSum);
+            const double maskNanos = timed(mask, maskSum);
+            rows.push_back({name, loopNanos, maskNanos, loopSum == maskSum});
+        };
+
+        compare("win test", [](const Position& pos) { return static_cast<uint64_t>(loopIsWin(pos)); },
+                [](const Position& pos) { return static_cast<uint64_t>(pos.isWin()); });
+        compare("foundation, tops+waste",
+                [](const Position& pos) {
+                    uint64_t playable = 0;
+                    for (int col = 0; col < TABLEAU_COLUMNS; col++) {
+                        const CardId top = pos.columnTop(col);
+                        if (top != NO_CARD && loopBuildsOnFoundation(pos, top)) playable |= uint64_t{1} << top;
+                    }
+                    if (!pos.wasteEmpty() && loopBuildsOnFoundation(pos, pos.wasteTop())) playable |= uint64_t{1} << pos.wasteTop();
+                    return playable;
+                },
+                [](const Position& pos) {
+                    return pos.foundationNext() & (pos.wasteEmpty() ? pos.tops : pos.tops | cardBit(pos.wasteTop()));
+                });
+        compare("tableau, 52 cards",
+                [](const Position& pos) {
+                    uint64_t accepted = 0;
+                    for (CardId card = 0; card < DECK_SIZE; card++) accepted |= static_cast<uint64_t>(loopStacksOnTop(pos, card)) << card;
+                    return accepted;
+                },
+                [](const Position& pos) { return pos.acceptedByTops(); });
+        compare("tableau, waste card",
+                [](const Position& pos) { return static_cast<uint64_t>(!pos.wasteEmpty() && loopStacksOnTop(pos, pos.wasteTop())); },
+                [](const Position& pos) { return static_cast<uint64_t>(!pos.wasteEmpty() && (pos.acceptedByTops() & cardBit(pos.wasteTop()))); });
+
+        std::cout << positions.size() << " positions from random draw-1 games, Position is " << sizeof(Position) << " bytes\n";
+        std::cout << std::left << std::setw(24) << "check" << std::right << std::setw(12) << "loop ns" << std::setw(12)
+                  << "mask ns" << std::setw(10) << "speedup" << std::setw(8) << "agree" << "\n";
+        bool agree = true;
+        for (const Row& row : rows) {
+            agree = agree && row.agree;
+            std::cout << std::left << std::setw(24) << row.name << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(12) << row.loopNanos << std::setw(12) << row.maskNanos << std::setw(9)
+                      << std::setprecision(1) << row.loopNanos / row.maskNanos << "x" << std::setw(8)
+                      << (row.agree ? "yes" : "NO") << "\n";
+        }
+
+        // Move generation and apply/undo now keep the masks up to date
+        size_t generated = 0;
+        const auto start = Clock::now();
+        for (Position pos : positions) {
+            EngineMove legal[MAX_MOVES];
+            const int count = generateMoves<Draw1Rules>(pos, legal);
+            for (int i = 0; i < count; i++) {
+                const MoveRecord record = applyMove<Draw1Rules>(pos, legal[i]);
+                generated += pos.isWin();
+                undoMove<Draw1Rules>(pos, record);
+            }
+            generated += static_cast<size_t>(count);
+        }
+        std::cout << "generate + apply/undo every move: " << std::setprecision(1)
+                  << secondsSince(start) / static_cast<double>(positions.size()) * 1e9 << " ns per position ("
+                  << generated << " moves)\n";
+        return agree ? 0 : 1;
+    }
+
+    // Evaluator throughput: one position at a time, and in batches split into
+    // filling the feature arrays and scoring them. The positions are gone
+    // over `passes` times, so a set that fits in cache measures the evaluator
+    // rather than memory.
+    int benchEval(const size_t positionCount, const int passes, const char* weightsPath) {
+        EvalWeights weights;
+        if (weightsPath) {
+            std::string error;
+            if (!weights.load(weightsPath, error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+        }
+        const Evaluator evaluator(weights);
+        const std::vector<Position> positions = randomPositions(positionCount);
+
+        std::cout << positions.size() << " positions x " << passes << " passes, batches scored with " << Evaluator::instructionSet() << ", weights";
+        for (size_t f = 0; f < EVAL_FEATURES; f++) {
+            std::cout << " " << EVAL_FEATURE_NAMES[f] << "=" << weights.weights[f];
+        }
+        std::cout << "\n";
+
+        std::vector<float> single(positions.size());
+        auto start = Clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i < positions.size(); i++) single[i] = evaluator.evaluate(positions[i]);
+        }
+        const double singleSeconds = secondsSince(start);
+
+        constexpr size_t BATCH = 4096;
+        EvalBatch batch(BATCH);
+        std::vector<float> scores(EvalBatch::padded(BATCH));
+        double fillSeconds = 0;
+        double scoreSeconds = 0;
+        float maxDifference = 0;
+        for (size_t first = 0; first < positions.size() * passes; first += BATCH) {
+            const size_t last = std::min(positions.size() * passes, first + BATCH);
+            start = Clock::now();
+            batch.clear();
+            for (size_t i = first; i < last; i++) batch.add(positions[i % positions.size()]);
+            fillSeconds += secondsSince(start);
+
+            start = Clock::now();
+            evaluator.evaluate(batch, scores.data());
+            scoreSeconds += secondsSince(start);
+
+            for (size_t i = first; i < last; i++) {
+                maxDifference = std::max(maxDifference, std::abs(scores[i - first] - single[i % positions.size()]));
+            }
+        }
+
+        const double evaluations = static_cast<double>(positions.size()) * passes;
+        const auto row = [evaluations](const char* name, const double seconds) {
+            std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(10) << seconds / evaluations * 1e9 << " ns" << std::setw(12) << std::setprecision(1)
+                      << evaluations / seconds / 1e6 << " M/s\n";
+        };
+        row("one at a time", singleSeconds);
+        row("batch: features", fillSeconds);
+        row("batch: scoring", scoreSeconds);
+        row("batch: total", fillSeconds + scoreSeconds);
+        std::cout << "largest difference from one at a time: " << std::setprecision(6) << maxDifference << "\n";
+        return maxDifference < 1e-3f ? 0 : 1;
+    }
+
+    // Legal moves after every step of random walks that apply and undo moves,
+    // generated again each time and read from a MoveCache. Both walks make the
+    // same choices, so their move lists fold into the same checksum.
+    template <typename Rules>
+    int benchMoveCache(const int games, const int steps) {
+        struct Totals {
+            double seconds = 0;
+            uint64_t checksum = 0;
+            size_t queries = 0;
+            size_t moves = 0;
+        };
+
+        const auto walk = [games, steps](const auto& step) {
+            Totals totals;
+            std::mt19937_64 rng(1);
+            std::vector<MoveRecord> records;
+            const auto start = Clock::now();
+            for (int game = 1; game <= games; game++) {
+                records.clear();
+                step.deal(static_cast<uint64_t>(game));
+                for (int i = 0; i < steps; i++) {
+                    EngineMove legal[Rules::maxMoves];
+                    const int count = step.moves(legal);
+                    totals.queries++;
+                    totals.moves += static_cast<size_t>(count);
+                    for (int k = 0; k < count; k++) {
+                        const EngineMove& move = legal[k];
+                        totals.checksum = totals.checksum * 31 + (static_cast<uint64_t>(move.type) << 24 | move.from << 16 | move.to << 8 | move.count);
+                    }
+
+                    // One step in four goes back, so undo is measured too
+                    if (!records.empty() && rng() % 4 == 0) {
+                        step.undo(records.back());
+                        records.pop_back();
+                    } else if (count > 0) {
+                        records.push_back(step.apply(legal[rng() % static_cast<size_t>(count)]));
+                    } else {
+                        break;
+                    }
+                }
+            }
+            totals.seconds = secondsSince(start);
+            return totals;
+        };
+
+        Position pos;
+        struct Regenerate {
+            Position& pos;
+            void deal(const uint64_t seed) const { pos = dealPosition(seed); }
+            int moves(EngineMove* out) const { return generateMoves<Rules>(pos, out); }
+            MoveRecord apply(const EngineMove& move) const { return applyMove<Rules>(pos, move); }
+            void undo(const MoveRecord& record) const { undoMove<Rules>(pos, record); }
+        };
+        MoveCache cache;
+        struct Cached {
+            Position& pos;
+            MoveCache& cache;
+            void deal(const uint64_t seed) const {
+                pos = dealPosition(seed);
+                cache.reset<Rules>(pos);
+            }
+            int moves(EngineMove* out) const { return cache.moves(out); }
+            MoveRecord apply(const EngineMove& move) const { return cache.apply<Rules>(pos, move); }
+            void undo(const MoveRecord& record) const { cache.undo<Rules>(pos, record); }
+        };
+
+        // Alternating rounds, the fastest of each kept
+        Totals regenerated = walk(Regenerate{pos});
+        Totals cached = walk(Cached{pos, cache});
+        for (int round = 1; round < 3; round++) {
+            const Totals again = walk(Regenerate{pos});
+            regenerated.seconds = std::min(regenerated.seconds, again.seconds);
+            cached.seconds = std::min(cached.seconds, walk(Cached{pos, cache}).seconds);
+        }
+
+        // The query alone, on positions where both are up to date
+        const std::vector<Position> positions = randomPositions(4096);
+        std::vector<MoveCache> caches(positions.size());
+        for (size_t i = 0; i < positions.size(); i++) caches[i].reset<Rules>(positions[i]);
+        constexpr int PASSES = 100;
+        EngineMove legal[Rules::maxMoves];
+        uint64_t generatedCount = 0, cachedCount = 0;
+        auto start = Clock::now();
+        for (int pass = 0; pass < PASSES; pass++) {
+            for (const Position& p : positions) generatedCount += static_cast<uint64_t>(generateMoves<Rules>(p, legal));
+        }
+        const double generateSeconds = secondsSince(start);
+        start = Clock::now();
+        for (int pass = 0; pass < PASSES; pass++) {
+            for (const MoveCache& c : caches) cachedCount += static_cast<uint64_t>(c.moves(legal));
+        }
+        const double readSeconds = secondsSince(start);
+
+        const auto perStep = [](const Totals& totals) { return totals.seconds / static_cast<double>(totals.queries) * 1e9; };
+        const double queries = static_cast<double>(positions.size()) * PASSES;
+        std::cout << regenerated.queries << " steps over " << games << " games, "
+                  << std::fixed << std::setprecision(1) << static_cast<double>(regenerated.moves) / static_cast<double>(regenerated.queries)
+                  << " legal moves per position\n"
+                  << std::setprecision(2)
+                  << "step + all moves, regenerated: " << std::setw(8) << perStep(regenerated) << " ns\n"
+                  << "step + all moves, cached:      " << std::setw(8) << perStep(cached) << " ns\n"
+                  << "all moves only, generated:     " << std::setw(8) << generateSeconds / queries * 1e9 << " ns\n"
+                  << "all moves only, from cache:    " << std::setw(8) << readSeconds / queries * 1e9 << " ns\n";
+
+        const bool agree = regenerated.checksum == cached.checksum && generatedCount == cachedCount;
+        std::cout << (agree ? "same moves both ways\n" : "MOVE LISTS DIFFER\n");
+        return agree ? 0 : 1;
+    }
+
+    // The dead-deal filter on seeds 1..deals, then against the solver. Every
+    // deal it rejects must be lost, so the solver replays up to `solved` of
+    // them; and of seeds 1..solved, the ones the solver proves lost but the
+    // filter let through are its false negatives.
+    template <typename Rules>
+    int benchDeadDeals(const int deals, const int solved, const size_t nodeLimit) {
+        std::vector<Position> positions;
+        positions.reserve(static_cast<size_t>(deals));
+        for (int seed = 1; seed <= deals; seed++) positions.push_back(dealPosition(static_cast<uint64_t>(seed)));
+
+        std::vector<DeadDeal> verdicts(positions.size());
+        const auto start = Clock::now();
+        for (size_t i = 0; i < positions.size(); i++) verdicts[i] = findDeadDeal<Rules>(positions[i]);
+        const double filterSeconds = secondsSince(start);
+
+        const auto rejected = [&verdicts](const DeadDeal dead) { return std::count(verdicts.begin(), verdicts.end(), dead); };
+        const auto percent = [](const double part, const double whole) { return whole > 0 ? 100.0 * part / whole : 0.0; };
+        const auto noMoves = rejected(DeadDeal::NoMoves);
+        const auto deadlocks = rejected(DeadDeal::Deadlock);
+        std::cout << "seeds 1.." << deals << ", draw " << Rules::drawCount << ", node limit " << nodeLimit << "\n"
+                  << std::fixed << std::setprecision(1) << "filter: " << filterSeconds / deals * 1e9 << " ns per deal, rejects "
+                  << std::setprecision(3) << percent(static_cast<double>(noMoves + deadlocks), deals) << "% ("
+                  << noMoves << " no moves, " << deadlocks << " deadlocks)\n";
+
+        const Solver<Rules> solver({nodeLimit});
+        int checked = 0, wronglyRejected = 0, confirmed = 0;
+        double solverSeconds = 0;
+        for (size_t i = 0; i < positions.size() && checked < solved; i++) {
+            if (verdicts[i] == DeadDeal::None) continue;
+            const auto solveStart = Clock::now();
+            const SolveResult result = solver.solve(positions[i]).result;
+            solverSeconds += secondsSince(solveStart);
+            checked++;
+            if (result == SolveResult::Solved) {
+                wronglyRejected++;
+                std::cout << "seed " << i + 1 << " rejected (" << deadDealName(verdicts[i]) << ") but solved\n";
+            }
+            if (result == SolveResult::Unsolvable) confirmed++;
+        }
+        std::cout << "rejected deals solved: " << checked << ", won " << wronglyRejected << ", proved lost " << confirmed
+                  << ", undecided " << checked - wronglyRejected - confirmed << ", solver " << std::setprecision(1)
+                  << (checked ? solverSeconds / checked * 1e3 : 0.0) << " ms per deal\n";
+
+        int won = 0, lost = 0, lostRejected = 0, undecided = 0;
+        for (int i = 0; i < std::min(solved, deals); i++) {
+            switch (solver.solve(positions[static_cast<size_t>(i)]).result) {
+                case SolveResult::Solved:
+                    won++;
+                    break;
+                case SolveResult::Unsolvable:
+                    lost++;
+                    if (verdicts[static_cast<size_t>(i)] != DeadDeal::None) lostRejected++;
+                    break;
+                case SolveResult::Unknown:
+                    undecided++;
+                    break;
+            }
+        }
+        std::cout << "seeds 1.." << std::min(solved, deals) << " by the solver: won " << won << ", lost " << lost
+                  << ", undecided " << undecided << "; the filter caught " << lostRejected << " of the lost, false negatives "
+                  << std::setprecision(1) << percent(lost - lostRejected, lost) << "%\n";
+        return wronglyRejected == 0 ? 0 : 1;
+    }
+
+    // Beam search against the exhaustive Solver on seeds 1..seeds: deals
+    // decided, solved per second of search and the memory each search took.
+    // Every beam solution is replayed. A deal one search wins and the other
+    // proves lost counts as an error.
+    template <typename Rules>
+    int benchBeam(const int seeds, const BeamOptions& beamOptions, const size_t nodeLimit) {
+        struct Tally {
+            int solved = 0, unsolvable = 0, unknown = 0;
+            double seconds = 0, slowest = 0;
+            size_t peakBytes = 0, totalBytes = 0;
+
+            void add(const SolverOutcome& outcome, const double elapsed) {
+                solved += outcome.result == SolveResult::Solved;
+                unsolvable += outcome.result == SolveResult::Unsolvable;
+                unknown += outcome.result == SolveResult::Unknown;
+                seconds += elapsed;
+                slowest = std::max(slowest, elapsed);
+                peakBytes = std::max(peakBytes, outcome.stats.memoryBytes);
+                totalBytes += outcome.stats.memoryBytes;
+            }
+        };
+
+        const Solver<Rules> exhaustive({nodeLimit});
+        const BeamSolver<Rules> beam(beamOptions);
+
+        Tally tallies[2];
+        int onlyExhaustive = 0, onlyBeam = 0, errors = 0;
+        for (int seed = 1; seed <= seeds; seed++) {
+            const Position deal = dealPosition(static_cast<uint64_t>(seed));
+
+            auto start = Clock::now();
+            const SolverOutcome full = exhaustive.solve(deal);
+            tallies[0].add(full, secondsSince(start));
+
+            start = Clock::now();
+            const SolverOutcome bounded = beam.solve(deal);
+            tallies[1].add(bounded, secondsSince(start));
+
+            if (bounded.result == SolveResult::Solved) {
+                Position pos = deal;
+                bool legal = true;
+                for (const EngineMove& move : bounded.solution) {
+                    if (!(legal = isLegalMove<Rules>(pos, move))) break;
+                    applyMove<Rules>(pos, move);
+                }
+                if (!legal || !pos.isWin() || full.result == SolveResult::Unsolvable) {
+                    std::cout << "seed " << seed << ": beam solution is " << (legal && pos.isWin() ? "for a lost deal" : "wrong") << "\n";
+                    errors++;
+                }
+            }
+            if (bounded.result == SolveResult::Unsolvable && full.result == SolveResult::Solved) {
+                std::cout << "seed " << seed << ": beam proved lost a deal the Solver won\n";
+                errors++;
+            }
+            onlyExhaustive += full.result == SolveResult::Solved && bounded.result != SolveResult::Solved;
+            onlyBeam += bounded.result == SolveResult::Solved && full.result != SolveResult::Solved;
+        }
+
+        std::cout << "seeds 1.." << seeds << ", draw " << Rules::drawCount << "; exhaustive node limit " << nodeLimit
+                  << "; beam width " << beamOptions.width << ", budget " << beamOptions.timeBudget.count() << " ms, cap "
+                  << (beamOptions.memoryCap >> 20) << " MB\n";
+        std::cout << std::setw(12) << "search"
+                  << std::setw(8) << "solved"
+                  << std::setw(8) << "lost"
+                  << std::setw(9) << "unknown"
+                  << std::setw(10) << "seconds"
+                  << std::setw(13) << "solved/sec"
+                  << std::setw(12) << "slowest s"
+                  << std::setw(10) << "peak MB"
+                  << std::setw(10) << "mean MB" << "\n";
+        const char* names[] = {"exhaustive", "beam"};
+        for (int i = 0; i < 2; i++) {
+            const Tally& t = tallies[i];
+            std::cout << std::setw(12) << names[i]
+                      << std::setw(8) << t.solved
+                      << std::setw(8) << t.unsolvable
+                      << std::setw(9) << t.unknown
+                      << std::setw(10) << std::fixed << std::setprecision(2) << t.seconds
+                      << std::setw(13) << std::setprecision(1) << (t.seconds > 0 ? t.solved / t.seconds : 0.0)
+                      << std::setw(12) << std::setprecision(3) << t.slowest
+                      << std::setw(10) << std::setprecision(1) << static_cast<double>(t.peakBytes) / (1 << 20)
+                      << std::setw(10) << static_cast<double>(t.totalBytes) / seeds / (1 << 20) << "\n";
+        }
+        std::cout << "solved only by exhaustive " << onlyExhaustive << ", only by beam " << onlyBeam
+                  << ", contradictions " << errors << "\n";
+        return errors == 0 ? 0 : 1;
+    }
+
+    // Replay verification throughput: solved deals submitted over and over,
+    // every tenth one tampered with, through a ScoreVerifier per thread count
+    int benchVerify(const int submissions, const std::vector<int>& threadCounts) {
+        std::vector<ScoreSubmission> wins;
+        const Solver<Draw1Rules> solver({200'000});
+        for (uint64_t seed = 1; wins.size() < 32 && seed < 1000; seed++) {
+            SolverOutcome outcome = solver.solve(dealPosition(seed));
+            if (outcome.result != SolveResult::Solved) continue;
+            const int moves = static_cast<int>(outcome.solution.size());
+            wins.push_back({"bench", seed, RuleVariant::Draw1, moves, std::move(outcome.solution)});
+        }
+
+        size_t logMoves = 0;
+        for (const ScoreSubmission& win : wins) logMoves += win.log.size();
+        std::cout << wins.size() << " solved deals, " << logMoves / wins.size() << " moves per game on average, "
+                  << submissions << " submissions, 1 in 10 tampered\n";
+        std::cout << std::setw(8) << "threads" << std::setw(12) << "seconds" << std::setw(14) << "games/s"
+                  << std::setw(10) << "accepted" << std::setw(10) << "rejected" << "\n";
+
+        for (const int threads : threadCounts) {
+            std::vector<VerifiedScore> verdicts;
+            size_t accepted = 0, rejected = 0;
+            const auto start = Clock::now();
+            {
+                ScoreVerifier verifier(threads, 1024);
+                for (int i = 0; i < submissions; i++) {
+                    ScoreSubmission submission = wins[i % wins.size()];
+                    if (i % 10 == 9) {
+                        if (i % 20 == 9) submission.moves--;       // claims fewer moves
+                        else submission.log[submission.log.size() / 2].to ^= 1; // edits a move
+                    }
+                    verifier.submit(std::move(submission));
+
+                    if (i % 1024 == 0) {
+                        verdicts.clear();
+                        verifier.collect(verdicts);
+                        for (const VerifiedScore& verdict : verdicts) (verdict.accepted() ? accepted : rejected)++;
+                    }
+                }
+                verifier.waitIdle();
+                verdicts.clear();
+                verifier.collect(verdicts);
+                for (const VerifiedScore& verdict : verdicts) (verdict.accepted() ? accepted : rejected)++;
+            }
+            const double elapsed = secondsSince(start);
+
+            std::cout << std::setw(8) << threads << std::setw(12) << std::fixed << std::setprecision(3) << elapsed
+                      << std::setw(14) << std::setprecision(0) << submissions / elapsed
+                      << std::setw(10) << accepted << std::setw(10) << rejected << "\n";
+        }
+        return 0;
+    }
+
+    // Frame of the present benchmark: the keys it shows and a console-sized
+    // body, so submitting copies about as much as ScreenBuffer::render
+    struct SimulatedFrame {
+        size_t keysShown = 0;
+        std::vector<char> cells;
+    };
+
+    // Keypress-to-display latency of a game loop whose frame write is slow
+    // (a busy console or terminal), writing inline as the game used to or
+    // through a RenderThread. Keys arrive every keyMicros like a held key
+    // and the loop takes one per pass.
+    int benchPresent(const int writeMicros, const int keyMicros, const int seconds) {
+        constexpr auto handleCost = std::chrono::microseconds(20); // handleInput + scene render
+        const auto writeCost = std::chrono::microseconds(writeMicros);
+        const auto keyInterval = std::chrono::microseconds(std::max(1, keyMicros));
+        const size_t keyCount = static_cast<size_t>(seconds) * 1'000'000 / static_cast<size_t>(std::max(1, keyMicros));
+
+        std::cout << "write " << writeMicros << " us per frame, a key every " << keyMicros << " us, " << keyCount
+                  << " keys\n";
+        std::cout << std::left << std::setw(10) << "output" << std::right << std::setw(10) << "shown"
+                  << std::setw(10) << "frames" << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms"
+                  << std::setw(10) << "max ms" << "\n";
+
+        for (const bool threaded : {false, true}) {
+            std::vector<double> latency(keyCount, -1);
+            size_t frames = 0;
+            const auto start = Clock::now();
+            const auto arrival = [&](const size_t key) { return start + keyInterval * key; };
+
+            // Stamps every key up to the frame's newest one with the time it became visible
+            size_t stamped = 0;
+            const auto shown = [&](const SimulatedFrame& frame) {
+                const auto now = Clock::now();
+                for (; stamped < frame.keysShown; stamped++) {
+                    latency[stamped] = std::chrono::duration<double, std::milli>(now - arrival(stamped)).count();
+                }
+                frames++;
+            };
+            const auto write = [&](const SimulatedFrame& frame) {
+                std::this_thread::sleep_for(writeCost);
+                shown(frame);
+            };
+
+            {
+                SimulatedFrame inlineFrame;
+                inlineFrame.cells.resize(120 * 40 * 4);
+                RenderThread<SimulatedFrame> presenter(write);
+
+                size_t handled = 0;
+                while (handled < keyCount) {
+                    if (Clock::now() < arrival(handled)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    for (const auto busy = Clock::now() + handleCost; Clock::now() < busy;) {}
+                    handled++;
+
+                    if (threaded) {
+                        SimulatedFrame& frame = presenter.frame();
+                        frame.keysShown = handled;
+                        frame.cells.assign(inlineFrame.cells.begin(), inlineFrame.cells.end());
+                        presenter.submit();
+                    } else {
+                        inlineFrame.keysShown = handled;
+                        write(inlineFrame);
+                    }
+                }
+            }
+
+            std::vector<double> sorted;
+            for (const double value : latency) {
+                if (value >= 0) sorted.push_back(value);
+            }
+            std::sort(sorted.begin(), sorted.end());
+            const auto at = [&](const double p) {
+                return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+            };
+
+            std::cout << std::left << std::setw(10) << (threaded ? "thread" : "inline") << std::right
+                      << std::setw(10) << sorted.size() << std::setw(10) << frames << std::fixed << std::setprecision(2)
+                      << std::setw(10) << at(0.5) << std::setw(10) << at(0.99)
+                      << std::setw(10) << (sorted.empty() ? 0.0 : sorted.back()) << "\n";
+        }
+        return 0;
+    }
+
+    int argOr(const int argc, char** argv, const int index, const int fallback) {
+        return argc > index ? std::atoi(argv[index]) : fallback;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::string_view command = argc > 1 ? argv[1] : "";
+
+    if (command == "canonical") {
+        return withRules(drawVariant(argOr(argc, argv, 3, 1)), [&](auto rules) {
+            return benchCanonical<decltype(rules)>(argOr(argc, argv, 2, 200), argOr(argc, argv, 4, 200000));
+        });
+    }
+
+    if (command == "arena") {
+        return withRules(drawVariant(argOr(argc, argv, 3, 1)), [&](auto rules) {
+            return benchArena<decltype(rules)>(argOr(argc, argv, 2, 200), static_cast<size_t>(argOr(argc, argv, 4, 200000)));
+        });
+    }
+
+    if (command == "tt") {
+        std::vector<int> threadCounts;
+        for (int i = 5; i < argc; i++) threadCounts.push_back(std::atoi(argv[i]));
+        if (threadCounts.empty()) threadCounts = {1, 8, 64};
+        return withRules(drawVariant(argOr(argc, argv, 3, 1)), [&](auto rules) {
+            return benchTranspositionTable<decltype(rules)>(argOr(argc, argv, 2, 50),
+                                                            static_cast<size_t>(argOr(argc, argv, 4, 64)), threadCounts);
+        });
+    }
+
+    if (command == "memo") {
+        return withRules(drawVariant(argOr(argc, argv, 3, 3)), [&](auto rules) {
+            return benchMemo<decltype(rules)>(argOr(argc, argv, 2, 5), static_cast<size_t>(argOr(argc, argv, 4, 16)),
+                                              static_cast<size_t>(argOr(argc, argv, 5, 20'000'000)));
+        });
+    }
+
+    if (command == "timeline") {
+        return benchTimeline(static_cast<size_t>(argOr(argc, argv, 2, 100000)), static_cast<size_t>(argOr(argc, argv, 3, 32)));
+    }
+
+    if (command == "present") {
+        return benchPresent(argOr(argc, argv, 2, 16000), argOr(argc, argv, 3, 10000), argOr(argc, argv, 4, 3));
+    }
+
+    if (command == "bitboards") {
+        return benchBitboards(static_cast<size_t>(argOr(argc, argv, 2, 1'000'000)));
+    }
+
+    if (command == "eval") {
+        return benchEval(static_cast<size_t>(argOr(argc, argv, 2, 4096)), std::max(1, argOr(argc, argv, 3, 250)),
+                         argc > 4 ? argv[4] : nullptr);
+    }
+
+    if (command == "movecache") {
+        return withRules(drawVariant(argOr(argc, argv, 4, 1)), [&](auto rules) {
+            return benchMoveCache<decltype(rules)>(argOr(argc, argv, 2, 2000), argOr(argc, argv, 3, 300));
+        });
+    }
+
+    if (command == "dead") {
+        return withRules(drawVariant(argOr(argc, argv, 4, 1)), [&](auto rules) {
+            return benchDeadDeals<decltype(rules)>(argOr(argc, argv, 2, 100000), argOr(argc, argv, 3, 500),
+                                                   static_cast<size_t>(argOr(argc, argv, 5, 200000)));
+        });
+    }
+
+    if (command == "beam") {
+        BeamOptions options;
+        options.width = static_cast<size_t>(argOr(argc, argv, 4, 256));
+        options.timeBudget = std::chrono::milliseconds(argOr(argc, argv, 5, 1000));
+        options.memoryCap = static_cast<size_t>(argOr(argc, argv, 6, 64)) << 20;
+        return withRules(drawVariant(argOr(argc, argv, 3, 3)), [&](auto rules) {
+            return benchBeam<decltype(rules)>(argOr(argc, argv, 2, 100), options,
+                                              static_cast<size_t>(argOr(argc, argv, 7, 2'000'000)));
+        });
+    }
+
+    if (command == "verify") {
+        std::vector<int> threadCounts;
+        for (int i = 3; i < argc; i++) threadCounts.push_back(std::atoi(argv[i]));
+        if (threadCounts.empty()) threadCounts = {1, 2, 4, 8};
+        return benchVerify(argOr(argc, argv, 2, 100000), threadCounts);
+    }
+
+    std::cerr << "usage: SolitaireBench canonical [seeds] [draw] [nodeLimit]\n"
+                 "       SolitaireBench arena [seeds] [draw] [nodeLimit]\n"
+                 "       SolitaireBench tt [seeds] [draw] [megabytes] [threads...]\n"
+                 "       SolitaireBench memo [seeds] [draw] [memoMegabytes] [nodeLimit]\n"
+                 "       SolitaireBench timeline [moves] [interval]\n"
+                 "       SolitaireBench verify [submissions] [threads...]\n"
+                 "       SolitaireBench present [writeMicros] [keyMicros] [seconds]\n"
+                 "       SolitaireBench bitboards [positions]\n"
+                 "       SolitaireBench eval [positions] [passes] [weightsFile]\n"
+                 "       SolitaireBench movecache [games] [steps] [draw]\n"
+                 "       SolitaireBench dead [deals] [solved] [draw] [nodeLimit]\n"
+                 "       SolitaireBench beam [seeds] [draw] [width] [budgetMillis] [capMegabytes] [nodeLimit]\n";
+    return 1;
+}
@@ -0,0 +1,663 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "AnsiEncoder.h"
+#include "MemoryBackend.h"
+#include "Position.h"
+#include "Rules.h"
+#include "SolitaireApp.h"
+#include "Solver.h"
+
+// Runs the whole UI with no console, its screens kept in memory:
+//   SolitaireHeadless latency [samples] [seed] [width] [height]
+//   SolitaireHeadless script [seed] [width] [height] > game.txt
+//   SolitaireHeadless play game.txt [runs]
+//   SolitaireHeadless ansi game.txt
+//
+// latency: plays random legal moves on easy deals by keyboard. Each key goes
+// into SolitaireApp::step the way the InputThread's would and is timed from
+// then until the frame answering it has landed in the memory screen. Reports
+// p50/p99/p999 for a stock draw, the key finishing a tableau move and the
+// arrow keys choosing a card in a tableau pile.
+//
+// script: writes a playback script that goes through the menu and wins an
+// easy deal by keyboard, from the solver's solution, ending in the frame the
+// win screen must show. play: runs a script as fast as the app goes, one
+// step per line with no waiting for frames, and reports the time per step
+// and whether the final frame matches.
+//
+// ansi: plays a script waiting for every frame, and encodes the frames of
+// the screen on show the way TerminalBackend writes them. Reports bytes per
+// frame against a full repaint and against a cursor move and colour code
+// for every cell.
+
+namespace {
+    using Clock = InputClock;
+    using Rules = Draw1Rules;
+
+    constexpr auto FRAME_TIMEOUT = std::chrono::seconds(1);
+    constexpr int MOVES_PER_GAME = 300; // then the harness restarts, random play rarely wins
+
+    KeyEvent character(const char ch) {
+        return {InputKey::Character, ch};
+    }
+
+    double percentile(const std::vector<double>& sorted, const double p) {
+        if (sorted.empty()) return 0;
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+    }
+
+    // Scratch files, so a run neither reads nor clobbers the player's
+    struct ScratchFiles {
+        AppConfig config;
+
+        ScratchFiles() {
+            const std::filesystem::path dir = std::filesystem::temp_directory_path();
+            config.scoresPath = (dir / "SolitaireHeadless-scores.txt").string();
+            config.savePath = (dir / "SolitaireHeadless-save.bin").string();
+            clean();
+        }
+
+        ~ScratchFiles() {
+            clean();
+        }
+
+        void clean() const {
+            std::error_code ignored;
+            std::filesystem::remove(config.scoresPath, ignored);
+            std::filesystem::remove(config.savePath, ignored);
+        }
+    };
+
+    // The app on a memory screen, fed one key per step
+    class Harness {
+    public:
+        Harness(const AppConfig& config, const short width, const short height)
+            : display(width, height), app(config, [this] { return display.makeBackend(); }) {}
+
+        // Steps with the key and waits for the frame answering it. Returns
+        // microseconds from the step to the frame landing, or a negative
+        // number if no frame came.
+        double press(KeyEvent key) {
+            const uint64_t before = display.frames();
+            key.time = Clock::now();
+            app.step({key});
+            if (!display.waitForFrames(before + 1, FRAME_TIMEOUT)) return -1;
+            return std::chrono::duration<double, std::micro>(display.lastLanded() - key.time).count();
+        }
+
+        // Steps with a key that need not change the screen
+        void type(const KeyEvent key) {
+            app.step({key});
+        }
+
+        // A step with no key, for the frame a screen change leaves pending
+        void settle() {
+            const uint64_t before = display.frames();
+            app.step({});
+            display.waitForFrames(before + 1, FRAME_TIMEOUT);
+        }
+
+        // Through the menu: easy, a name, then a dealt game on screen
+        void startGame() {
+            press({InputKey::Enter, 0});
+            for (const char ch : std::string_view("bench")) press(character(ch));
+            press({InputKey::Enter, 0});
+            settle();
+        }
+
+        const SolitaireGame& game() const {
+            return app.getGame();
+        }
+
+        SolitaireApp::Screen screen() const {
+            return app.screen();
+        }
+
+    private:
+        MemoryDisplay display;
+        SolitaireApp app;
+    };
+
+    struct Action {
+        const char* name;
+        std::vector<double> micros;
+        size_t missed = 0; // keys that brought no frame
+    };
+
+    // The keys a player presses for an engine move, see SolitaireGame::handleInput
+    std::vector<KeyEvent> keysForMove(const Position& pos, const EngineMove& move) {
+        using Type = EngineMove::Type;
+        constexpr char foundationKeys[] = "erty";
+        const auto column = [](const int index) { return character(static_cast<char>('1' + index)); };
+
+        switch (move.type) {
+            case Type::Draw:
+            case Type::Recycle:
+                return {character('q')};
+            case Type::WasteToFoundation:
+                return {character('w'), character(foundationKeys[move.to])};
+            case Type::WasteToTableau:
+                return {character('w'), column(move.to)};
+            case Type::FoundationToTableau:
+                return {character(foundationKeys[move.from]), column(move.to)};
+            case Type::TableauToFoundation:
+            case Type::TableauToTableau:
+                break;
+        }
+
+        // With several cards face up the top one is chosen first, and the
+        // arrows pick a deeper one
+        std::vector<KeyEvent> keys{column(move.from)};
+        if (pos.countFaceUp(move.from) > 1) {
+            keys.insert(keys.end(), move.count - 1, {InputKey::LeftArrow, 0});
+            keys.push_back({InputKey::Enter, 0});
+        }
+        keys.push_back(move.type == Type::TableauToTableau ? column(move.to) : character(foundationKeys[move.to]));
+        return keys;
+    }
+
+    int benchLatency(const size_t samples, const uint64_t seed, const short width, const short height) {
+        ScratchFiles files;
+        Action draw{"stock draw", {}, 0};
+        Action tableau{"tableau move", {}, 0};
+        Action select{"card select", {}, 0};
+        const auto timed = [](Harness& harness, Action& action, const KeyEvent key) {
+            const double micros = harness.press(key);
+            if (micros < 0) {
+                action.missed++;
+            } else {
+                action.micros.push_back(micros);
+            }
+        };
+
+        std::mt19937_64 rng(seed);
+        size_t games = 0;
+        size_t moves = 0;
+        const auto start = Clock::now();
+
+        while (draw.micros.size() < samples || tableau.micros.size() < samples || select.micros.size() < samples) {
+            // A won game leaves the app on the win screen for good
+            AppConfig config = files.config;
+            config.dealSeed = rng() | 1;
+            auto harness = std::make_unique<Harness>(config, width, height);
+            harness->startGame();
+
+            while (harness->screen() == SolitaireApp::Screen::Game &&
+                   (draw.micros.size() < samples || tableau.micros.size() < samples || select.micros.size() < samples)) {
+                games++;
+                Position pos = dealPosition(harness->game().getSeed());
+
+                for (int played = 0; played < MOVES_PER_GAME && !pos.isWin(); played++) {
+                    EngineMove legal[MAX_MOVES];
+                    const int count = generateMoves<Rules>(pos, legal);
+                    if (count == 0) break;
+                    const EngineMove move = legal[rng() % static_cast<size_t>(count)];
+
+                    std::vector<KeyEvent> keys = keysForMove(pos, move);
+                    const bool choosing = keys.size() > 2;
+                    if (choosing && move.count == 1) {
+                        // Arrows there and back, for samples of single-card moves too
+                        keys.insert(keys.begin() + 1, {{InputKey::LeftArrow, 0}, {InputKey::RightArrow, 0}});
+                    }
+
+                    for (size_t i = 0; i < keys.size(); i++) {
+                        const KeyEvent& key = keys[i];
+                        if (move.type == EngineMove::Type::Draw) {
+                            timed(*harness, draw, key);
+                        } else if (key.key == InputKey::LeftArrow || key.key == InputKey::RightArrow) {
+                            timed(*harness, select, key);
+                        } else if (move.type == EngineMove::Type::TableauToTableau && i + 1 == keys.size()) {
+                            timed(*harness, tableau, key);
+                        } else {
+                            harness->press(key);
+                        }
+                    }
+
+                    applyMove<Rules>(pos, move);
+                    moves++;
+                    if (harness->game().moves != played + 1) {
+                        std::cerr << "game " << harness->game().getSeed() << ": the UI did not play move " << played + 1
+                                  << " the way the engine did\n";
+                        return 1;
+                    }
+                }
+
+                if (!pos.isWin()) harness->type(character('p'));
+                harness->settle();
+            }
+        }
+
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << width << "x" << height << " memory screen, " << games << " games, " << moves << " moves in "
+                  << std::fixed << std::setprecision(1) << seconds << " s\n";
+        std::cout << std::left << std::setw(14) << "action" << std::right << std::setw(9) << "samples"
+                  << std::setw(9) << "p50 us" << std::setw(9) << "p99 us" << std::setw(10) << "p999 us"
+                  << std::setw(9) << "max us" << std::setw(8) << "missed" << "\n";
+        for (Action* action : {&draw, &tableau, &select}) {
+            std::sort(action->micros.begin(), action->micros.end());
+            std::cout << std::left << std::setw(14) << action->name << std::right << std::setw(9) << action->micros.size()
+                      << std::setprecision(1) << std::setw(9) << percentile(action->micros, 0.5)
+                      << std::setw(9) << percentile(action->micros, 0.99) << std::setw(10) << percentile(action->micros, 0.999)
+                      << std::setw(9) << (action->micros.empty() ? 0.0 : action->micros.back())
+                      << std::setw(8) << action->missed << "\n";
+        }
+        return 0;
+    }
+
+    // A playback script, one step per line with the keys typed during it:
+    //   # comment
+    //   size 120 40            screen size, before the first step
+    //   seed 7                 seeds the deals, before the first step
+    //   bench<enter>           keys; whitespace is skipped, <space> <enter>
+    //                          <backspace> <left> <right> stand for the rest
+    //   expect won 1f2e...     final screen (menu, game, won) and fingerprint
+    struct Script {
+        short width = 120;
+        short height = 40;
+        uint64_t seed = 1;
+        std::vector<std::vector<KeyEvent>> steps;
+        std::string expectScreen; // empty: nothing expected
+        uint64_t expectFingerprint = 0;
+    };
+
+    constexpr std::pair<std::string_view, KeyEvent> NAMED_KEYS[] = {
+        {"<space>", {InputKey::Character, ' '}},
+        {"<enter>", {InputKey::Enter, 0}},
+        {"<backspace>", {InputKey::Backspace, 0}},
+        {"<left>", {InputKey::LeftArrow, 0}},
+        {"<right>", {InputKey::RightArrow, 0}},
+    };
+
+    std::string keyToken(const KeyEvent& key) {
+        for (const auto& [name, named] : NAMED_KEYS) {
+            if (named.key == key.key && (key.key != InputKey::Character || named.ch == key.ch)) return std::string(name);
+        }
+        return std::string(1, key.ch);
+    }
+
+    bool parseSteps(const std::string_view line, std::vector<KeyEvent>& keys) {
+        for (size_t i = 0; i < line.size();) {
+            if (line[i] == ' ' || line[i] == '\t' || line[i] == '\r') {
+                i++;
+                continue;
+            }
+            if (line[i] != '<') {
+                keys.push_back(character(line[i++]));
+                continue;
+            }
+            const auto named = std::find_if(std::begin(NAMED_KEYS), std::end(NAMED_KEYS),
+                                            [&](const auto& entry) { return line.substr(i).starts_with(entry.first); });
+            if (named == std::end(NAMED_KEYS)) return false;
+            keys.push_back(named->second);
+            i += named->first.size();
+        }
+        return true;
+    }
+
+    bool parseScript(std::istream& in, Script& script, std::string& error) {
+        std::string line;
+        for (size_t number = 1; std::getline(in, line); number++) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            std::istringstream words(line);
+            std::string word;
+            words >> word;
+            if (word == "size" || word == "seed") {
+                if (!script.steps.empty()) {
+                    error = "line " + std::to_string(number) + ": " + word + " after the first step";
+                    return false;
+                }
+                int width = 0, height = 0;
+                if (word == "size" ? !(words >> width >> height) || width <= 0 || height <= 0 : !(words >> script.seed)) {
+                    error = "line " + std::to_string(number) + ": bad " + word;
+                    return false;
+                }
+                if (word == "size") {
+                    script.width = static_cast<short>(width);
+                    script.height = static_cast<short>(height);
+                }
+            } else if (word == "expect") {
+                if (!(words >> script.expectScreen >> std::hex >> script.expectFingerprint)) {
+                    error = "line " + std::to_string(number) + ": bad expect";
+                    return false;
+                }
+            } else {
+                std::vector<KeyEvent>& keys = script.steps.emplace_back();
+                if (!parseSteps(line, keys)) {
+                    error = "line " + std::to_string(number) + ": unknown key name";
+                    return false;
+                }
+            }
+        }
+        if (script.steps.empty()) {
+            error = "no steps";
+            return false;
+        }
+        return true;
+    }
+
+    const char* screenName(const SolitaireApp::Screen screen) {
+        switch (screen) {
+            case SolitaireApp::Screen::Menu: return "menu";
+            case SolitaireApp::Screen::Game: return "game";
+            case SolitaireApp::Screen::Won:  return "won";
+        }
+        return "?";
+    }
+
+    // FNV-1a over the characters and colours of a frame
+    uint64_t fingerprint(const std::vector<CHAR_INFO>& cells) {
+        uint64_t hash = 14695981039346656037ull;
+        const auto mix = [&hash](const uint32_t value) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                hash = (hash ^ ((value >> shift) & 0xFF)) * 1099511628211ull;
+            }
+        };
+        for (const CHAR_INFO& cell : cells) {
+            mix(static_cast<uint32_t>(cell.Char.UnicodeChar));
+            mix(cell.Attributes);
+        }
+        return hash;
+    }
+
+    struct Playback {
+        std::vector<double> stepMicros;
+        uint64_t frames = 0; // presented; the rest were dropped for newer ones
+        SolitaireApp::Screen screen = SolitaireApp::Screen::Menu;
+        uint64_t fingerprint = 0;
+    };
+
+    // Every step goes in as soon as the last returns. Afterwards the app is
+    // left to settle: a step for a screen change the last key caused, and
+    // one once the verifier has recorded a win, then the frames are flushed.
+    Playback play(const Script& script, AppConfig config) {
+        config.dealSeed = script.seed;
+        MemoryDisplay display(script.width, script.height);
+        SolitaireApp app(config, [&display] { return display.makeBackend(); });
+
+        Playback result;
+        result.stepMicros.reserve(script.steps.size());
+        for (const std::vector<KeyEvent>& keys : script.steps) {
+            const auto start = Clock::now();
+            app.step(keys);
+            result.stepMicros.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+
+        app.step({});
+        app.waitForScores();
+        app.step({});
+        app.flush();
+
+        result.frames = display.frames();
+        result.screen = app.screen();
+        result.fingerprint = fingerprint(display.shown());
+        return result;
+    }
+
+    int writeScript(const uint64_t seed, const short width, const short height) {
+        constexpr int ATTEMPTS = 100;
+        constexpr size_t NODE_LIMIT = 2'000'000;
+        ScratchFiles files;
+
+        for (uint64_t appSeed = seed; appSeed < seed + ATTEMPTS; appSeed++) {
+            // The deal the app will show for this seed. The last attempt's
+            // save would turn the menu into a resume prompt, so it goes first
+            files.clean();
+            AppConfig config = files.config;
+            config.dealSeed = appSeed;
+            const uint64_t deal = [&] {
+                Harness harness(config, width, height);
+                harness.startGame();
+                return harness.game().getSeed();
+            }();
+
+            Position pos = dealPosition(deal);
+            const SolverOutcome outcome = Solver<Rules>({NODE_LIMIT}).solve(pos);
+            if (outcome.result != SolveResult::Solved) continue;
+
+            Script script;
+            script.width = width;
+            script.height = height;
+            script.seed = appSeed;
+            script.steps.push_back({{InputKey::Enter, 0}});
+            for (const char ch : std::string_view("bench")) script.steps.push_back({character(ch)});
+            script.steps.push_back({{InputKey::Enter, 0}});
+            for (const EngineMove& move : outcome.solution) {
+                for (const KeyEvent& key : keysForMove(pos, move)) script.steps.push_back({key});
+                applyMove<Rules>(pos, move);
+            }
+
+            files.clean();
+            const Playback result = play(script, files.config);
+            if (result.screen != SolitaireApp::Screen::Won) {
+                std::cerr << "deal " << deal << ": the solution did not win through the UI\n";
+                return 1;
+            }
+
+            std::cout << "# Deal " << deal << " (draw 1) won in " << outcome.solution.size() << " moves, "
+                      << script.steps.size() << " keys\n"
+                      << "size " << width << " " << height << "\n"
+                      << "seed " << appSeed << "\n";
+            for (const std::vector<KeyEvent>& keys : script.steps) {
+                for (const KeyEvent& key : keys) std::cout << keyToken(key);
+                std::cout << "\n";
+            }
+            std::cout << "expect " << screenName(result.screen) << " " << std::hex << std::setw(16) << std::setfill('0')
+                      << result.fingerprint << "\n";
+            return 0;
+        }
+
+        std::cerr << "no deal solved in " << ATTEMPTS << " seeds from " << seed << "\n";
+        return 1;
+    }
+
+    int playScript(const char* path, const int runs) {
+        std::ifstream in(path);
+        Script script;
+        std::string error;
+        if (!in) error = "cannot open";
+        if (!in || !parseScript(in, script, error)) {
+            std::cerr << path << ": " << error << "\n";
+            return 1;
+        }
+
+        ScratchFiles files;
+        std::vector<double> stepMicros;
+        Playback first;
+        bool stable = true;
+        const auto start = Clock::now();
+        for (int run = 0; run < runs; run++) {
+            files.clean();
+            Playback result = play(script, files.config);
+            stepMicros.insert(stepMicros.end(), result.stepMicros.begin(), result.stepMicros.end());
+            if (run == 0) {
+                first = std::move(result);
+            } else if (result.fingerprint != first.fingerprint || result.screen != first.screen) {
+                stable = false;
+            }
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::sort(stepMicros.begin(), stepMicros.end());
+
+        std::cout << path << ": " << script.steps.size() << " steps x " << runs << " runs in " << std::fixed
+                  << std::setprecision(3) << seconds << " s, " << std::setprecision(0)
+                  << static_cast<double>(stepMicros.size()) / seconds << " steps/s\n"
+                  << "step us: p50 " << std::setprecision(1) << percentile(stepMicros, 0.5)
+                  << ", p99 " << percentile(stepMicros, 0.99) << ", max "
+                  << (stepMicros.empty() ? 0.0 : stepMicros.back()) << "; first run presented " << first.frames
+                  << " frames\n"
+                  << "final screen " << screenName(first.screen) << ", fingerprint " << std::hex << std::setw(16)
+                  << std::setfill('0') << first.fingerprint << std::dec << "\n";
+
+        if (!stable) {
+            std::cout << "runs ended on different frames\n";
+            return 1;
+        }
+        if (!script.expectScreen.empty()) {
+            const bool matches = script.expectScreen == screenName(first.screen) &&
+                                 script.expectFingerprint == first.fingerprint;
+            std::cout << (matches ? "matches the expected frame\n" : "does NOT match the expected frame\n");
+            if (!matches) return 1;
+        }
+        return 0;
+    }
+
+    // Sizes of the frames a terminal would have been sent
+    struct AnsiMeter {
+        std::mutex mutex;
+        const void* active = nullptr;
+        std::vector<double> diffed;  // AnsiEncoder against the last frame
+        std::vector<double> whole;   // AnsiEncoder from a blank screen
+        std::vector<double> perCell; // a move and both colours before every cell
+    };
+
+    // A memory screen whose frames are also encoded, as TerminalBackend does
+    class MeteredBackend : public ScreenBackend {
+    public:
+        MeteredBackend(AnsiMeter& meter, std::unique_ptr<ScreenBackend> screen) : meter(meter), screen(std::move(screen)) {}
+
+        void initialSize(short& width, short& height) override {
+            screen->initialSize(width, height);
+        }
+
+        bool resized(short& width, short& height) override {
+            return screen->resized(width, height);
+        }
+
+        void activate() override {
+            screen->activate();
+            std::lock_guard lock(meter.mutex);
+            meter.active = this;
+            encoder.reset();
+            if (!last.cells.empty()) measure(last);
+        }
+
+        void present(const ConsoleFrame& frame) override {
+            screen->present(frame);
+            std::lock_guard lock(meter.mutex);
+            last.width = frame.width;
+            last.height = frame.height;
+            last.cells.assign(frame.cells.begin(), frame.cells.end());
+            if (meter.active == this) measure(last);
+        }
+
+    private:
+        AnsiMeter& meter;
+        std::unique_ptr<ScreenBackend> screen;
+        ConsoleFrame last;
+        AnsiEncoder encoder;
+        AnsiEncoder blank;
+
+        void measure(const ConsoleFrame& frame) {
+            meter.diffed.push_back(static_cast<double>(encoder.encode(frame).size()));
+            blank.reset();
+            meter.whole.push_back(static_cast<double>(blank.encode(frame).size()));
+
+            // ESC [ row ; col H  ESC [ 0 ; fg ; bg m  and the character
+            double bytes = 0;
+            for (int y = 0; y < frame.height; y++) {
+                for (int x = 0; x < frame.width; x++) {
+                    const auto code = static_cast<uint32_t>(frame.cells[static_cast<size_t>(y) * frame.width + x].Char.UnicodeChar);
+                    bytes += 4 + std::to_string(y + 1).size() + std::to_string(x + 1).size() + 10 +
+                             (code < 0x80 ? 1 : code < 0x800 ? 2 : 3);
+                }
+            }
+            meter.perCell.push_back(bytes);
+        }
+    };
+
+    int ansiReport(const char* path) {
+        std::ifstream in(path);
+        Script script;
+        std::string error;
+        if (!in) error = "cannot open";
+        if (!in || !parseScript(in, script, error)) {
+            std::cerr << path << ": " << error << "\n";
+            return 1;
+        }
+
+        ScratchFiles files;
+        AppConfig config = files.config;
+        config.dealSeed = script.seed;
+        MemoryDisplay display(script.width, script.height);
+        AnsiMeter meter;
+        {
+            SolitaireApp app(config, [&] { return std::make_unique<MeteredBackend>(meter, display.makeBackend()); });
+            for (const std::vector<KeyEvent>& keys : script.steps) {
+                app.step(keys);
+                app.flush(); // no frame is dropped for a newer one
+            }
+            app.step({});
+            app.waitForScores();
+            app.step({});
+            app.flush();
+        }
+
+        std::lock_guard lock(meter.mutex);
+        std::cout << path << ": " << script.width << "x" << script.height << ", " << meter.diffed.size()
+                  << " frames on show\n";
+        std::cout << std::left << std::setw(22) << "bytes per frame" << std::right << std::setw(9) << "mean"
+                  << std::setw(9) << "p50" << std::setw(9) << "p99" << std::setw(9) << "max" << std::setw(12) << "total"
+                  << "\n";
+        const std::pair<const char*, std::vector<double>*> rows[] = {
+            {"move+colour per cell", &meter.perCell}, {"full repaint", &meter.whole}, {"diffed", &meter.diffed}};
+        for (const auto& [name, sizes] : rows) {
+            double total = 0;
+            for (const double size : *sizes) total += size;
+            std::sort(sizes->begin(), sizes->end());
+            std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(0)
+                      << std::setw(9) << (sizes->empty() ? 0.0 : total / static_cast<double>(sizes->size()))
+                      << std::setw(9) << percentile(*sizes, 0.5) << std::setw(9) << percentile(*sizes, 0.99)
+                      << std::setw(9) << (sizes->empty() ? 0.0 : sizes->back()) << std::setw(12) << total << "\n";
+        }
+        return 0;
+    }
+
+    int argOr(const int argc, char** argv, const int index, const int fallback) {
+        return argc > index ? std::atoi(argv[index]) : fallback;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::string_view command = argc > 1 ? argv[1] : "";
+
+    if (command == "latency") {
+        return benchLatency(static_cast<size_t>(argOr(argc, argv, 2, 2000)), static_cast<uint64_t>(argOr(argc, argv, 3, 1)),
+                            static_cast<short>(argOr(argc, argv, 4, 120)), static_cast<short>(argOr(argc, argv, 5, 40)));
+    }
+
+    if (command == "script") {
+        return writeScript(static_cast<uint64_t>(argOr(argc, argv, 2, 1)), static_cast<short>(argOr(argc, argv, 3, 120)),
+                           static_cast<short>(argOr(argc, argv, 4, 40)));
+    }
+
+    if (command == "play" && argc > 2) {
+        return playScript(argv[2], std::max(1, argOr(argc, argv, 3, 1)));
+    }
+
+    if (command == "ansi" && argc > 2) {
+        return ansiReport(argv[2]);
+    }
+
+    std::cerr << "usage: SolitaireHeadless latency [samples] [seed] [width] [height]\n"
+                 "       SolitaireHeadless script [seed] [width] [height]\n"
+                 "       SolitaireHeadless play <script> [runs]\n"
+                 "       SolitaireHeadless ansi <script>\n";
+    return 1;
+}
@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Load generator for SolitaireServer (Linux only):
+//   SolitaireLoad [--port N | --unix PATH] [--sessions N] [--active N] [--requests N] [--threads N]
+//
+// Opens --sessions connections and starts a game on each, then reads the
+// server's resident memory to report bytes per idle session. After that
+// --active of them play random legal moves ("moves", then one of the
+// moves) from --threads threads, and the request rate and round-trip
+// latency are reported.
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Endpoint {
+        int port = 7777;
+        std::string unixPath;
+    };
+
+    // Blocking connection with line-at-a-time replies
+    class Client {
+    public:
+        explicit Client(const Endpoint& endpoint) {
+            if (endpoint.unixPath.empty()) {
+                fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (fd < 0) return;
+                sockaddr_in address{};
+                address.sin_family = AF_INET;
+                address.sin_port = htons(static_cast<uint16_t>(endpoint.port));
+                address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                const int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) disconnect();
+            } else {
+                sockaddr_un address{};
+                if (endpoint.unixPath.size() >= sizeof(address.sun_path)) return;
+                fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (fd < 0) return;
+                address.sun_family = AF_UNIX;
+                std::memcpy(address.sun_path, endpoint.unixPath.c_str(), endpoint.unixPath.size() + 1);
+                if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) disconnect();
+            }
+        }
+
+        ~Client() {
+            disconnect();
+        }
+
+        Client(Client&& other) noexcept : fd(other.fd), buffer(std::move(other.buffer)) {
+            other.fd = -1;
+        }
+
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+        Client& operator=(Client&&) = delete;
+
+        bool connected() const {
+            return fd >= 0;
+        }
+
+        bool send(const std::string_view request) {
+            std::string line(request);
+            line += '\n';
+            size_t sent = 0;
+            while (sent < line.size()) {
+                const ssize_t written = write(fd, line.data() + sent, line.size() - sent);
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                sent += static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+        bool receive(std::string& reply) {
+            while (true) {
+                const size_t newline = buffer.find('\n');
+                if (newline != std::string::npos) {
+                    reply.assign(buffer, 0, newline);
+                    buffer.erase(0, newline + 1);
+                    return true;
+                }
+
+                char chunk[4096];
+                const ssize_t received = read(fd, chunk, sizeof(chunk));
+                if (received < 0 && errno == EINTR) continue;
+                if (received <= 0) return false;
+                buffer.append(chunk, static_cast<size_t>(received));
+            }
+        }
+
+        bool request(const std::string_view request, std::string& reply) {
+            return send(request) && receive(reply);
+        }
+
+    private:
+        int fd = -1;
+        std::string buffer;
+
+        void disconnect() {
+            if (fd >= 0) close(fd);
+            fd = -1;
+        }
+    };
+
+    // Reads a number out of a "key:value" field of a reply
+    size_t field(const std::string& reply, const std::string& key) {
+        const size_t at = reply.find(key + ":");
+        return at == std::string::npos ? 0 : std::strtoull(reply.c_str() + at + key.size() + 1, nullptr, 10);
+    }
+
+    struct PlayResult {
+        std::vector<double> latencies; // microseconds per request
+        size_t games = 0;
+        size_t wins = 0;
+        bool failed = false;
+    };
+
+    // Random legal moves on each client in turn, a new deal when one is won or stuck
+    void play(std::vector<Client>& clients, const size_t first, const size_t count, const int requests,
+              const uint64_t seed, PlayResult& result) {
+        std::mt19937_64 rng(seed);
+        std::string reply;
+        std::vector<std::string_view> moves;
+        result.latencies.reserve(static_cast<size_t>(requests) * 2);
+
+        const auto timed = [&](Client& client, const std::string_view request) {
+            const auto start = Clock::now();
+            const bool ok = client.request(request, reply);
+            result.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            return ok;
+        };
+
+        for (int i = 0; i < requests; i++) {
+            Client& client = clients[first + static_cast<size_t>(i) % count];
+
+            if (!timed(client, "moves")) {
+                result.failed = true;
+                return;
+            }
+            moves.clear();
+            for (size_t at = reply.find(' '); at != std::string::npos;) {
+                const size_t end = reply.find(' ', at + 1);
+                moves.push_back(std::string_view(reply).substr(at + 1, end == std::string::npos ? end : end - at - 1));
+                at = end;
+            }
+
+            const std::string move = moves.empty() ? "" : std::string(moves[rng() % moves.size()]);
+            if (moves.empty() || (timed(client, move) && reply.ends_with(" win"))) {
+                if (!moves.empty()) result.wins++;
+                result.games++;
+                if (!timed(client, "new " + std::to_string(rng() % 1'000'000))) {
+                    result.failed = true;
+                    return;
+                }
+            }
+        }
+    }
+
+    double percentile(const std::vector<double>& sorted, const double p) {
+        if (sorted.empty()) return 0;
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+    }
+
+    int usage() {
+        std::cerr << "usage: SolitaireLoad [--port N | --unix PATH] [--sessions N] [--active N] [--requests N] "
+                     "[--threads N]\n";
+        return 1;
+    }
+}
+
+int main(const int argc, char** argv) {
+    Endpoint endpoint;
+    size_t sessions = 10'000;
+    size_t active = 100;
+    int requests = 100'000;
+    int threads = 4;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) return usage();
+        const char* value = argv[++i];
+
+        if (arg == "--port") {
+            endpoint.port = std::atoi(value);
+        } else if (arg == "--unix") {
+            endpoint.unixPath = value;
+        } else if (arg == "--sessions") {
+            sessions = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--active") {
+            active = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--requests") {
+            requests = std::atoi(value);
+        } else if (arg == "--threads") {
+            threads = std::max(1, std::atoi(value));
+        } else {
+            return usage();
+        }
+    }
+    active = std::max<size_t>(1, std::min(active, sessions));
+    threads = static_cast<int>(std::min<size_t>(static_cast<size_t>(threads), active));
+
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    Client control(endpoint);
+    std::string reply;
+    if (!control.connected() || !control.request("stats", reply)) {
+        std::cerr << "cannot reach the server\n";
+        return 1;
+    }
+    const size_t rssBefore = field(reply, "rss");
+
+    // Pipelined: every "new" goes out before the replies are read
+    std::vector<Client> clients;
+    clients.reserve(sessions);
+    const auto openStart = Clock::now();
+    for (size_t i = 0; i < sessions; i++) {
+        Client client(endpoint);
+        if (!client.connected() || !client.send("new " + std::to_string(i + 1))) {
+            std::cerr << "connection " << i + 1 << " failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+        clients.push_back(std::move(client));
+    }
+    for (Client& client : clients) {
+        if (!client.receive(reply) || !reply.starts_with("state")) {
+            std::cerr << "unexpected reply to new: " << reply << "\n";
+            return 1;
+        }
+    }
+    const double openSeconds = std::chrono::duration<double>(Clock::now() - openStart).count();
+    if (clients.empty()) return 1;
+
+    control.request("stats", reply);
+    const size_t rssAfter = field(reply, "rss");
+    std::cout << clients.size() << " sessions opened in " << std::fixed << std::setprecision(2) << openSeconds
+              << " s, server rss " << (rssBefore >> 10) << " KB -> " << (rssAfter >> 10) << " KB, "
+              << (rssAfter > rssBefore ? (rssAfter - rssBefore) / clients.size() : 0)
+              << " bytes per idle session (Connection is " << field(reply, "connection") << " bytes)\n";
+
+    active = std::min(active, clients.size());
+    std::vector<PlayResult> results(static_cast<size_t>(threads));
+    std::vector<std::thread> workers;
+    const auto playStart = Clock::now();
+    for (int t = 0; t < threads; t++) {
+        const size_t first = active * static_cast<size_t>(t) / static_cast<size_t>(threads);
+        const size_t last = active * static_cast<size_t>(t + 1) / static_cast<size_t>(threads);
+        workers.emplace_back(play, std::ref(clients), first, last - first, requests / threads,
+                             static_cast<uint64_t>(t + 1), std::ref(results[t]));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double playSeconds = std::chrono::duration<double>(Clock::now() - playStart).count();
+
+    std::vector<double> latencies;
+    size_t games = 0, wins = 0;
+    for (const PlayResult& result : results) {
+        if (result.failed) std::cerr << "a session stopped answering\n";
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        games += result.games;
+        wins += result.wins;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << active << " active sessions on " << threads << " threads: " << latencies.size() << " requests in "
+              << std::setprecision(2) << playSeconds << " s, " << std::setprecision(0)
+              << static_cast<double>(latencies.size()) / playSeconds << " requests/s, " << games << " games ended ("
+              << wins << " won)\n"
+              << "round trip us: p50 " << std::setprecision(1) << percentile(latencies, 0.5)
+              << ", p99 " << percentile(latencies, 0.99) << ", p999 " << percentile(latencies, 0.999) << "\n";
+
+    control.request("stats", reply);
+    std::cout << "server: " << reply << "\n";
+    return 0;
+}
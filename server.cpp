@@ -0,0 +1,403 @@
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Session.h"
+
+// Hosts many games in one process (Linux only):
+//   SolitaireServer [--port N | --unix PATH]
+//
+// One epoll loop on one thread serves every client; each connection owns a
+// Session (Session.h has the protocol) and nothing else while it is idle.
+// Requests are read into a shared buffer and replies built in a shared
+// buffer and written straight away, so a connection only holds bytes of its
+// own when a line arrives split or the socket cannot take a whole reply.
+//
+// Memory per idle session, user space (x86-64, libstdc++):
+//   sizeof(Connection)          320 bytes, also in the "stats" reply
+//   heap block overhead         16 bytes
+//   slot in the fd table        8 bytes
+// which SolitaireLoad measures as about 370 bytes of server RSS per session.
+// The kernel adds the socket itself (a few hundred bytes to about 1 KB for
+// an idle loopback/Unix socket, more while its buffers hold data) and about
+// 150 bytes for the epoll entry. RLIMIT_NOFILE is raised to the hard limit
+// at startup; tens of thousands of sessions usually need that hard limit
+// raised too (ulimit -Hn).
+//
+// Besides the Session requests the server answers "stats" with
+//   stats sessions:<open> peak:<most open> rss:<bytes> connection:<bytes>
+
+namespace {
+    constexpr size_t MAX_REQUEST = 256; // longer lines close the connection
+    constexpr size_t MAX_PENDING = 64 * 1024; // unsent reply bytes before a client counts as stuck
+
+    struct Connection {
+        int fd = -1;
+        Session session;
+        std::string partial; // start of a request whose newline has not arrived
+        std::string pending; // reply bytes the socket did not take yet
+    };
+
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    size_t residentBytes() {
+        long pages = 0, resident = 0;
+        if (std::FILE* statm = std::fopen("/proc/self/statm", "r")) {
+            if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+            std::fclose(statm);
+        }
+        return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    void raiseFileLimit() {
+        rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    int listenTcp(const int port) {
+        const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+
+        const int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    int listenUnix(const std::string& path) {
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path)) return -1;
+
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        unlink(path.c_str());
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    class Server {
+    public:
+        explicit Server(const int listener) : listener(listener), epoll(epoll_create1(EPOLL_CLOEXEC)) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = listener;
+            epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+            readBuffer.resize(64 * 1024);
+        }
+
+        ~Server() {
+            for (const auto& connection : connections) {
+                if (connection) close(connection->fd);
+            }
+            close(epoll);
+            close(spare);
+        }
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        void run() {
+            std::vector<epoll_event> events(1024);
+            while (!stopRequested) {
+                const int ready = epoll_wait(epoll, events.data(), static_cast<int>(events.size()), -1);
+                if (ready < 0) {
+                    if (errno == EINTR) continue;
+                    std::cerr << "epoll_wait: " << std::strerror(errno) << "\n";
+                    return;
+                }
+
+                for (int i = 0; i < ready; i++) {
+                    const int fd = events[i].data.fd;
+                    if (fd == listener) {
+                        acceptAll();
+                        continue;
+                    }
+
+                    Connection* connection = find(fd);
+                    if (!connection) continue;
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                        drop(*connection);
+                        continue;
+                    }
+                    if ((events[i].events & EPOLLOUT) && !flushPending(*connection)) continue;
+                    if (events[i].events & EPOLLIN) readRequests(*connection);
+                }
+            }
+        }
+
+        size_t peakSessions() const {
+            return peak;
+        }
+
+    private:
+        int listener;
+        int epoll;
+        int spare = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        bool refusedAny = false;
+        std::vector<std::unique_ptr<Connection>> connections; // indexed by fd
+        size_t open = 0;
+        size_t peak = 0;
+        std::string readBuffer;
+        std::string replies; // replies to one read, reused between reads
+
+        Connection* find(const int fd) const {
+            return static_cast<size_t>(fd) < connections.size() ? connections[fd].get() : nullptr;
+        }
+
+        void acceptAll() {
+            while (true) {
+                const int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    if (errno == EMFILE || errno == ENFILE) refuseOne();
+                    return;
+                }
+
+                const int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // fails harmlessly on Unix sockets
+
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLRDHUP;
+                event.data.fd = fd;
+                if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+                    close(fd);
+                    continue;
+                }
+
+                if (static_cast<size_t>(fd) >= connections.size()) connections.resize(fd + 1024);
+                connections[fd] = std::make_unique<Connection>();
+                connections[fd]->fd = fd;
+                peak = std::max(peak, ++open);
+            }
+        }
+
+        // Out of descriptors the pending client would keep the listener
+        // readable forever; the spare descriptor lets it be accepted and
+        // closed straight away
+        void refuseOne() {
+            if (!refusedAny) {
+                std::cerr << "accept: out of file descriptors at " << open << " sessions, refusing clients\n";
+                refusedAny = true;
+            }
+            close(spare);
+            const int fd = accept(listener, nullptr, nullptr);
+            if (fd >= 0) close(fd);
+            spare = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        }
+
+        void drop(Connection& connection) {
+            const int fd = connection.fd;
+            epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+            connections[fd].reset();
+            open--;
+        }
+
+        void readRequests(Connection& connection) {
+            replies.clear();
+            bool closed = false;
+
+            while (true) {
+                const ssize_t received = read(connection.fd, readBuffer.data(), readBuffer.size());
+                if (received == 0) {
+                    closed = true;
+                    break;
+                }
+                if (received < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) closed = true;
+                    break;
+                }
+
+                if (!handleBytes(connection, std::string_view(readBuffer.data(), static_cast<size_t>(received)))) {
+                    closed = true;
+                    break;
+                }
+            }
+
+            // Answer what did arrive even if the client has hung up
+            if (!replies.empty() && !send(connection, replies)) return;
+            if (closed) drop(connection);
+        }
+
+        // Runs every complete request in data, keeps a trailing fragment
+        bool handleBytes(Connection& connection, std::string_view data) {
+            while (!data.empty()) {
+                const size_t newline = data.find('\n');
+                if (newline == std::string_view::npos) {
+                    if (connection.partial.size() + data.size() > MAX_REQUEST) return false;
+                    connection.partial.append(data);
+                    return true;
+                }
+
+                std::string_view request = data.substr(0, newline);
+                data.remove_prefix(newline + 1);
+                if (!connection.partial.empty()) {
+                    if (connection.partial.size() + request.size() > MAX_REQUEST) return false;
+                    connection.partial.append(request);
+                    handleRequest(connection, connection.partial);
+                    std::string().swap(connection.partial);
+                } else {
+                    if (request.size() > MAX_REQUEST) return false;
+                    handleRequest(connection, request);
+                }
+            }
+            return true;
+        }
+
+        void handleRequest(Connection& connection, std::string_view request) {
+            if (request.ends_with('\r')) request.remove_suffix(1);
+            if (request == "stats") {
+                replies += "stats sessions:" + std::to_string(open) + " peak:" + std::to_string(peak) +
+                           " rss:" + std::to_string(residentBytes()) +
+                           " connection:" + std::to_string(sizeof(Connection)) + "\n";
+                return;
+            }
+            connection.session.handle(request, replies);
+        }
+
+        // Returns false if the connection was dropped
+        bool send(Connection& connection, const std::string_view data) {
+            // Replies queue behind anything still unsent, in order
+            if (!connection.pending.empty()) {
+                if (connection.pending.size() + data.size() > MAX_PENDING) {
+                    drop(connection);
+                    return false;
+                }
+                connection.pending.append(data);
+                return true;
+            }
+
+            size_t sent = 0;
+            while (sent < data.size()) {
+                const ssize_t written = write(connection.fd, data.data() + sent, data.size() - sent);
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) return true; // the hangup shows up in epoll
+                    break;
+                }
+                sent += static_cast<size_t>(written);
+            }
+
+            if (sent < data.size()) {
+                connection.pending.assign(data.substr(sent));
+                watchWrites(connection, true);
+            }
+            return true;
+        }
+
+        // Returns false if the connection was dropped
+        bool flushPending(Connection& connection) {
+            while (!connection.pending.empty()) {
+                const ssize_t written = write(connection.fd, connection.pending.data(), connection.pending.size());
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+                    drop(connection);
+                    return false;
+                }
+                connection.pending.erase(0, static_cast<size_t>(written));
+            }
+
+            std::string().swap(connection.pending);
+            watchWrites(connection, false);
+            return true;
+        }
+
+        void watchWrites(const Connection& connection, const bool enabled) {
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP | (enabled ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+            event.data.fd = connection.fd;
+            epoll_ctl(epoll, EPOLL_CTL_MOD, connection.fd, &event);
+        }
+    };
+
+    int usage() {
+        std::cerr << "usage: SolitaireServer [--port N | --unix PATH]\n";
+        return 1;
+    }
+}
+
+int main(const int argc, char** argv) {
+    int port = 7777;
+    std::string unixPath;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) return usage();
+        const char* value = argv[++i];
+
+        if (arg == "--port") {
+            port = std::atoi(value);
+        } else if (arg == "--unix") {
+            unixPath = value;
+        } else {
+            return usage();
+        }
+    }
+
+    raiseFileLimit();
+    std::signal(SIGPIPE, SIG_IGN);
+
+    struct sigaction stop{};
+    stop.sa_handler = [](int) { stopRequested = 1; };
+    sigaction(SIGINT, &stop, nullptr);
+    sigaction(SIGTERM, &stop, nullptr);
+
+    const int listener = unixPath.empty() ? listenTcp(port) : listenUnix(unixPath);
+    if (listener < 0) {
+        std::cerr << "cannot listen on " << (unixPath.empty() ? "127.0.0.1:" + std::to_string(port) : unixPath)
+                  << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    rlimit files{};
+    getrlimit(RLIMIT_NOFILE, &files);
+    std::cout << "listening on " << (unixPath.empty() ? "127.0.0.1:" + std::to_string(port) : unixPath)
+              << ", up to " << files.rlim_cur << " descriptors, " << sizeof(Connection) << " bytes per connection"
+              << std::endl;
+
+    size_t peak = 0;
+    {
+        Server server(listener);
+        server.run();
+        peak = server.peakSessions();
+    }
+
+    close(listener);
+    if (!unixPath.empty()) unlink(unixPath.c_str());
+    std::cout << "stopped, peak " << peak << " sessions" << std::endl;
+    return 0;
+}